@@ -6,6 +6,7 @@
 #define SERVO2_PIN 2
 #define TRANSISTOR_PIN 5
 #define VIBRATION_PIN 10
+#define LIGHT_BARRIER_PIN 20
 
 // Set to 0 (e.g. via `-D VIBRATION_MOTOR_ENABLED=0` in platformio.ini) on
 // hardware builds that don't have a vibration motor wired up - VibrationService
@@ -13,3 +14,11 @@
 #ifndef VIBRATION_MOTOR_ENABLED
 #define VIBRATION_MOTOR_ENABLED 1
 #endif
+
+// Set to 1 (e.g. via `-D LIGHT_BARRIER_ENABLED=1` in platformio.ini) on
+// hardware with the light barrier (media/3d/lichtschranke.stl) fitted below
+// the hopper outlet. Without it FeedingService takes every cycle as a
+// dispensed portion and never touches LIGHT_BARRIER_PIN.
+#ifndef LIGHT_BARRIER_ENABLED
+#define LIGHT_BARRIER_ENABLED 0
+#endif
@@ -1,46 +1,63 @@
 #include "ClockService.hpp"
-
-ClockService::ClockService() : available(false), timeTrusted(false), lastSyncTime(0) {}
-
-uint8_t ClockService::lastSundayOfMonth(uint16_t year, uint8_t month) {
-    DateTime firstOfNextMonth = month == 12
-        ? DateTime(year + 1, 1, 1, 0, 0, 0)
-        : DateTime(year, month + 1, 1, 0, 0, 0);
-    DateTime lastOfMonth(firstOfNextMonth.unixtime() - 24 * 60 * 60);
-    return lastOfMonth.day() - lastOfMonth.dayOfTheWeek();
+#include "PinConfig.h"
+#include <esp_timer.h>
+
+// The DS3231 only counts whole seconds, so re-reading it more often than
+// this cannot add precision - it just costs an I2C transaction
+static const int64_t CACHE_REFRESH_US = 1000000;
+// A reading this recent satisfies a forced read
+static const int64_t FRESH_READ_US = 10000;
+// Time, alarm, control and status registers - one burst refreshes them all
+static const uint8_t CACHE_READ_LEN = DS3231_REG_STATUS + 1;
+
+// A sync only corrects the RTC when it is off by at least this much. Smaller
+// errors are below the DS3231's one-second resolution, and leaving the clock
+// alone keeps the drift baseline running across the frequent syncs from an
+// open web UI.
+static const int32_t DRIFT_ADJUST_THRESHOLD_MS = 2000;
+// Shorter intervals are dominated by the one-second quantization
+static const uint32_t DRIFT_MIN_INTERVAL_S = 24UL * 3600UL;
+// Beyond this the "error" is a wrong clock or zone, not oscillator drift
+static const int32_t DRIFT_MAX_PPB = 200000;
+static const int32_t AGING_PPB_PER_LSB = 100;
+
+// Sub-second sync: start looking for the RTC's tick this long before the
+// target second, and give up on the measurement this close to it
+static const int64_t SYNC_PHASE_LEAD_US = 1200000;
+static const int64_t SYNC_LATE_US = 100000;
+static const int64_t SYNC_WRITE_MARGIN_US = 2000;
+// A sync deferred by a busy device this long is dropped: the timer-to-UTC
+// offset goes stale (esp_timer drifts by ~10 ppm, 3 ms here)
+static const int64_t SYNC_MAX_DEFER_US = 300000000;
+// A measured error below this is left alone; it is about what the round
+// trip over the soft-AP can resolve
+static const int32_t SYNC_TOLERANCE_MS = 20;
+// waitForSecond() is meant for the last second before a deadline
+static const int64_t WAIT_FOR_SECOND_MAX_US = 2100000;
+
+volatile bool ClockService::alarmInterruptPending = false;
+
+// Error in ms, saturated: a clock off by more than ~24.8 days (e.g. never
+// set) must still read as a huge error, not wrap around to a small one
+static int32_t clampErrorMs(int64_t errorMs) {
+    if (errorMs > INT32_MAX) return INT32_MAX;
+    if (errorMs < -INT32_MAX) return -INT32_MAX;
+    return (int32_t)errorMs;
 }
 
-bool ClockService::isDstEuropeBerlinFromUtc(const DateTime &utcTime) {
-    const uint8_t month = utcTime.month();
-    if (month < 3 || month > 10) return false;
-    if (month > 3 && month < 10) return true;
-
-    const uint8_t lastSunday = lastSundayOfMonth(utcTime.year(), month);
-    if (month == 3) {
-        return utcTime.day() > lastSunday ||
-               (utcTime.day() == lastSunday && utcTime.hour() >= 1);
-    }
-
-    return utcTime.day() < lastSunday ||
-           (utcTime.day() == lastSunday && utcTime.hour() < 1);
+void IRAM_ATTR ClockService::onAlarmInterrupt() {
+    alarmInterruptPending = true;
 }
 
-bool ClockService::isDstEuropeBerlinLocal(const DateTime &localTime) {
-    const uint8_t month = localTime.month();
-    if (month < 3 || month > 10) return false;
-    if (month > 3 && month < 10) return true;
-
-    const uint8_t lastSunday = lastSundayOfMonth(localTime.year(), month);
-    if (month == 3) {
-        return localTime.day() > lastSunday ||
-               (localTime.day() == lastSunday && localTime.hour() >= 3);
-    }
-
-    return localTime.day() < lastSunday ||
-           (localTime.day() == lastSunday && localTime.hour() < 3);
-}
+ClockService::ClockService()
+    : available(false), timeTrusted(false), lastSyncTime(0),
+      cachedTime(0), cachedAtUs(0), cachedReadUs(0), cacheValid(false),
+      rtcSetTime(0), agingOffset(0), driftResidualPpb(0),
+      syncPending(false), syncSecond(0), syncAtUs(0), syncRequestedUs(0),
+      syncState(TIME_SYNC_NONE) {}
 
 bool ClockService::begin() {
+    // One burst: time, alarms, control, status and aging register
     if (!rtc.begin()) {
         Serial.println("[CLOCK] DS3231 not found!");
         available = false;
@@ -48,7 +65,7 @@ bool ClockService::begin() {
         return false;
     }
 
-    bool lostPower = rtc.lostPower();
+    bool lostPower = rtc.shadow(DS3231_REG_STATUS) & DS3231_OSF;
     if (lostPower) {
         Serial.println("[CLOCK] RTC lost power, needs time sync!");
     }
@@ -57,8 +74,31 @@ bool ClockService::begin() {
     timeTrusted = !lostPower;
     lastSyncTime = millis();
 
-    DateTime now = rtc.now();
-    Serial.printf("[CLOCK] DS3231 initialized. Current time: %04d-%02d-%02d %02d:%02d:%02d\n",
+    if (configService) {
+        rtcSetTime = configService->getRtcSetTime();
+        agingOffset = configService->getAgingOffset();
+        driftResidualPpb = configService->getDriftResidualPpb();
+
+        // The aging register is battery-backed like the clock itself; when
+        // the oscillator stopped (or the module was swapped) it no longer
+        // holds the learned value
+        if (agingOffset != (int8_t)rtc.shadow(DS3231_REG_AGING)) {
+            writeAgingOffset(agingOffset);
+        }
+    }
+
+    // INT/SQW is open-drain and active low; it stays low while any alarm
+    // flag is set, so an alarm that fired before we got here (the wake
+    // alarm) has no edge left - pick it up from the level instead
+    pinMode(RTC_INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(RTC_INT_PIN), onAlarmInterrupt, FALLING);
+    rearmAlarmInterrupt();
+
+    cachedTime = rtc.getTime().unixtime();
+    cachedAtUs = cachedReadUs = esp_timer_get_time();
+    cacheValid = true;
+    DateTime now(cachedTime);
+    Serial.printf("[CLOCK] DS3231 initialized. Current time: %04d-%02d-%02d %02d:%02d:%02d UTC\n",
                   now.year(), now.month(), now.day(),
                   now.hour(), now.minute(), now.second());
 
@@ -79,38 +119,364 @@ bool ClockService::setTime(uint32_t unixTime) {
         return false;
     }
 
-    const DateTime utcTime(unixTime);
-    const bool isDst = isDstEuropeBerlinFromUtc(utcTime);
-    const int32_t timezoneOffset = isDst ? 7200 : 3600;
-    DateTime localTime(unixTime + timezoneOffset);
-    rtc.adjust(localTime);
     lastSyncTime = millis();
+    // Supersedes a pending sub-second sync
+    syncPending = false;
+    syncState = TIME_SYNC_NONE;
+
+    if (timeTrusted) {
+        uint32_t rtcTime = now(true).unixtime();
+        int32_t rawErrorMs = clampErrorMs(((int64_t)cachedTime - unixTime) * 1000);
+        int32_t errorMs = clampErrorMs(((int64_t)rtcTime - unixTime) * 1000);
+        if (!syncNeedsWrite(unixTime, rawErrorMs, errorMs, DRIFT_ADJUST_THRESHOLD_MS)) {
+            return true;
+        }
+    }
+
+    return commitTime(unixTime);
+}
+
+bool ClockService::syncTime(int64_t utcOffsetUs) {
+    if (!available) {
+        Serial.println("[CLOCK] RTC not available!");
+        return false;
+    }
+
+    lastSyncTime = millis();
+
+    // First whole UTC second that leaves room to find the RTC's tick
+    syncRequestedUs = esp_timer_get_time();
+    int64_t utcUs = syncRequestedUs + utcOffsetUs;
+    syncSecond = (uint32_t)((utcUs + SYNC_PHASE_LEAD_US) / 1000000) + 1;
+    syncAtUs = (int64_t)syncSecond * 1000000 - utcOffsetUs;
+    syncPending = true;
+    syncState = TIME_SYNC_PENDING;
+    return true;
+}
+
+void ClockService::update(bool idle) {
+    if (!syncPending) return;
+
+    int64_t nowUs = esp_timer_get_time();
+    if (nowUs - syncRequestedUs > SYNC_MAX_DEFER_US) {
+        Serial.println("[CLOCK] Time sync dropped - device busy for too long");
+        syncPending = false;
+        syncState = TIME_SYNC_FAILED;
+        return;
+    }
+    if (nowUs < syncAtUs - SYNC_PHASE_LEAD_US) return;
+
+    if (!idle || nowUs > syncAtUs - SYNC_PHASE_LEAD_US + SYNC_LATE_US) {
+        // Measuring blocks loop() for up to SYNC_PHASE_LEAD_US, which a
+        // running feed can't spare (the gate would stay open too long).
+        // Likewise if loop() was held up: move to a later second rather
+        // than measure against half a window.
+        uint32_t skip = (uint32_t)((nowUs - syncAtUs + SYNC_PHASE_LEAD_US) / 1000000) + 1;
+        syncSecond += skip;
+        syncAtUs += (int64_t)skip * 1000000;
+        return;
+    }
+    syncPending = false;
+
+    // The instant the RTC ticks is a whole RTC second, so its distance to
+    // the UTC boundary is the RTC's error to the millisecond
+    uint32_t tickTime;
+    int64_t tickUs;
+    bool write = true;
+    if (timeTrusted && pollRtcTick(syncAtUs - SYNC_WRITE_MARGIN_US, tickTime, tickUs)) {
+        int64_t utcAtTickMs = (int64_t)syncSecond * 1000 - (syncAtUs - tickUs) / 1000;
+        int32_t rawErrorMs = clampErrorMs((int64_t)tickTime * 1000 - utcAtTickMs);
+        int32_t errorMs = rawErrorMs - driftCorrectionMs(tickTime);
+        write = syncNeedsWrite(syncSecond, rawErrorMs, errorMs, SYNC_TOLERANCE_MS);
+    }
+
+    // Writing the seconds register restarts the DS3231's countdown chain,
+    // so the write itself sets the phase
+    while (esp_timer_get_time() < syncAtUs) {
+    }
+    syncState = !write || commitTime(syncSecond) ? TIME_SYNC_DONE : TIME_SYNC_FAILED;
+}
+
+bool ClockService::pollRtcTick(int64_t deadlineUs, uint32_t &tickTime, int64_t &tickUs) {
+    // A plain read only tells which second the RTC is in, not where in it -
+    // poll the time registers (~0.3 ms per read) until the seconds change
+    if (!rtc.read(DS3231_REG_TIME, 7)) return false;
+    const uint8_t lastSecond = rtc.shadow(DS3231_REG_TIME);
+
+    int64_t afterUs;
+    while (true) {
+        int64_t beforeUs = esp_timer_get_time();
+        if (beforeUs >= deadlineUs || !rtc.read(DS3231_REG_TIME, 7)) return false;
+        afterUs = esp_timer_get_time();
+        if (rtc.shadow(DS3231_REG_TIME) != lastSecond) {
+            tickUs = (beforeUs + afterUs) / 2;
+            break;
+        }
+    }
+
+    // The cache now knows the RTC's phase, so now() rolls over to the
+    // millisecond from here on
+    tickTime = rtc.getTime().unixtime();
+    cachedTime = tickTime;
+    cachedAtUs = cachedReadUs = afterUs;
+    cacheValid = true;
+    return true;
+}
+
+bool ClockService::waitForSecond(uint32_t utcTime, int64_t &tickUs) {
+    if (!available) return false;
+
+    const uint32_t rtcTarget = uncorrectDrift(utcTime);
+    const int64_t deadlineUs = esp_timer_get_time() + WAIT_FOR_SECOND_MAX_US;
+    uint32_t tickTime;
+    if (!refreshCache() || cachedTime >= rtcTarget) return false;
+
+    while (pollRtcTick(deadlineUs, tickTime, tickUs)) {
+        if (tickTime >= rtcTarget) return true;
+    }
+    return false;
+}
+
+bool ClockService::syncNeedsWrite(uint32_t trueTime, int32_t rawErrorMs, int32_t errorMs, int32_t thresholdMs) {
+    // Compare before overwriting: this is the only moment the RTC's
+    // accumulated error is known. A recorded sample always resets the
+    // baseline, so samples never overlap.
+    bool sampled = configService && learnDrift(rawErrorMs, trueTime, thresholdMs);
+
+    if (!sampled && abs(errorMs) < thresholdMs) {
+        Serial.printf("[CLOCK] Time sync: RTC within %ld ms - not adjusted\n", (long)abs(errorMs));
+        return false;
+    }
+    return true;
+}
+
+bool ClockService::commitTime(uint32_t unixTime) {
+    const bool isDst = timeZone.isDstUtc(unixTime);
+    DateTime localTime(toLocal(unixTime));
+    if (!writeTime(unixTime)) {
+        return false;
+    }
     timeTrusted = true;
 
+    rtcSetTime = unixTime;
+    if (configService) {
+        configService->setRtcSetTime(unixTime);
+    }
+
     Serial.printf("[CLOCK] Time set to: %04d-%02d-%02d %02d:%02d:%02d (%s)\n",
                   localTime.year(), localTime.month(), localTime.day(),
                   localTime.hour(), localTime.minute(), localTime.second(),
-                  isDst ? "CEST" : "CET");
+                  timeZone.getName(isDst));
 
     return true;
 }
 
-DateTime ClockService::now() {
+DateTime ClockService::now(bool forceRead) {
     if (!available) {
         // Return epoch time if RTC not available
         return DateTime((uint32_t)0);
     }
-    return rtc.now();
+
+    int64_t sinceReadUs = esp_timer_get_time() - cachedReadUs;
+    if (!cacheValid || sinceReadUs >= CACHE_REFRESH_US || (forceRead && sinceReadUs >= FRESH_READ_US)) {
+        // On a failed read keep extrapolating from the last good one
+        refreshCache();
+    }
+    if (!cacheValid) return DateTime(correctDrift(cachedTime));
+
+    // Counted from the tick bound, which is never earlier than the RTC's
+    // tick: the seconds roll over no sooner than the RTC's do, so time
+    // stays monotonic, and no later than the bound is loose
+    int64_t sinceTickUs = esp_timer_get_time() - cachedAtUs;
+    return DateTime(correctDrift(cachedTime + (uint32_t)(sinceTickUs / 1000000)));
+}
+
+ClockSnapshot ClockService::snapshot(bool forceRead) {
+    ClockSnapshot snap;
+    snap.utc = now(forceRead);
+
+    if (!available) {
+        snap.local = snap.utc;
+        snap.utcOffsetSeconds = 0;
+        snap.timeZoneName = "UTC";
+        return snap;
+    }
+
+    uint32_t utcTime = snap.utc.unixtime();
+    bool isDst = timeZone.isDstUtc(utcTime);
+    snap.utcOffsetSeconds = timeZone.utcOffsetForUtc(utcTime);
+    snap.local = DateTime(utcTime + snap.utcOffsetSeconds);
+    snap.timeZoneName = timeZone.getName(isDst);
+    return snap;
 }
 
 int32_t ClockService::getCurrentUtcOffsetSeconds() {
-    if (!available) return 0;
-    return isDstEuropeBerlinLocal(rtc.now()) ? 7200 : 3600;
+    return snapshot().utcOffsetSeconds;
 }
 
 const char* ClockService::getCurrentTimeZoneName() {
-    if (!available) return "UTC";
-    return isDstEuropeBerlinLocal(rtc.now()) ? "CEST" : "CET";
+    return snapshot().timeZoneName;
+}
+
+bool ClockService::setTimeZone(const char *posix) {
+    if (strcmp(posix, timeZone.getRule()) == 0) return true;
+
+    if (!timeZone.set(posix)) {
+        Serial.printf("[CLOCK] Invalid time zone rule: %s\n", posix);
+        return false;
+    }
+    Serial.printf("[CLOCK] Time zone set to %s\n", posix);
+    return true;
+}
+
+bool ClockService::convertRtcToUtc() {
+    if (!available) return false;
+
+    // Nothing worth converting - the next sync writes UTC anyway
+    if (!timeTrusted) return true;
+
+    uint32_t local = now(true).unixtime();
+    uint32_t utcTime = toUtc(local);
+    if (!writeTime(utcTime)) return false;
+
+    Serial.printf("[CLOCK] RTC converted from local time to UTC (%+ld s)\n",
+                  (long)utcTime - (long)local);
+    return true;
+}
+
+bool ClockService::refreshCache() {
+    if (!rtc.read(DS3231_REG_TIME, CACHE_READ_LEN)) return false;
+    int64_t readUs = esp_timer_get_time();
+    uint32_t readTime = rtc.getTime().unixtime();
+
+    // The second just read began at or before readUs. The previous bound
+    // carried forward may be tighter, so the bound closes in on the real
+    // tick as reads land at different points of the second - unless the
+    // two disagree (the RTC was written, or the timers drifted apart), then
+    // it starts over from here.
+    int64_t tickUs = readUs;
+    if (cacheValid && readTime >= cachedTime) {
+        int64_t carriedUs = cachedAtUs + (int64_t)(readTime - cachedTime) * 1000000;
+        if (carriedUs <= readUs && carriedUs > readUs - 1000000) {
+            tickUs = carriedUs;
+        }
+    }
+
+    cachedTime = readTime;
+    cachedAtUs = tickUs;
+    cachedReadUs = readUs;
+    cacheValid = true;
+    return true;
+}
+
+bool ClockService::writeTime(uint32_t utcTime) {
+    uint8_t time[7];
+    Ds3231::encodeTime(DateTime(utcTime), time);
+    if (!rtc.write(DS3231_REG_TIME, time, sizeof(time))) {
+        Serial.println("[CLOCK] Failed to write time");
+        return false;
+    }
+    // Writing the seconds register restarts the second, so the phase is known
+    cachedTime = utcTime;
+    cachedAtUs = cachedReadUs = esp_timer_get_time();
+    cacheValid = true;
+
+    // The oscillator-stop flag is what marks the time as untrusted on boot
+    if (rtc.shadow(DS3231_REG_STATUS) & DS3231_OSF) {
+        rtc.writeRegister(DS3231_REG_STATUS, rtc.statusClearing(DS3231_OSF));
+    }
+    return true;
+}
+
+int32_t ClockService::driftCorrectionMs(uint32_t rawTime) const {
+    if (driftResidualPpb == 0 || rtcSetTime == 0 || rawTime <= rtcSetTime) return 0;
+    return (int32_t)((int64_t)(rawTime - rtcSetTime) * driftResidualPpb / 1000000LL);
+}
+
+uint32_t ClockService::correctDrift(uint32_t rawTime) const {
+    if (driftResidualPpb == 0 || rtcSetTime == 0 || rawTime <= rtcSetTime) return rawTime;
+
+    int64_t correction = (int64_t)(rawTime - rtcSetTime) * driftResidualPpb / 1000000000LL;
+    return rawTime - (int32_t)correction;
+}
+
+uint32_t ClockService::uncorrectDrift(uint32_t utcTime) const {
+    if (driftResidualPpb == 0 || rtcSetTime == 0 || utcTime <= rtcSetTime) return utcTime;
+
+    // Round towards later RTC time, so an alarm never fires before utcTime
+    int64_t scaled = (int64_t)(utcTime - rtcSetTime) * driftResidualPpb;
+    int64_t correction = scaled >= 0 ? (scaled + 999999999LL) / 1000000000LL : scaled / 1000000000LL;
+    return utcTime + (int32_t)correction;
+}
+
+bool ClockService::learnDrift(int32_t errorMs, uint32_t trueTime, int32_t minErrorMs) {
+    if (rtcSetTime == 0 || trueTime <= rtcSetTime) return false;
+
+    uint32_t interval = trueTime - rtcSetTime;
+    if (interval < DRIFT_MIN_INTERVAL_S || abs(errorMs) < minErrorMs) {
+        // Too early to tell - keep the baseline running
+        return false;
+    }
+
+    int64_t ratePpb = (int64_t)errorMs * 1000000LL / interval;
+    if (ratePpb > DRIFT_MAX_PPB || ratePpb < -DRIFT_MAX_PPB) {
+        Serial.printf("[CLOCK] Ignoring implausible drift of %lld ppb\n", (long long)ratePpb);
+        return false;
+    }
+
+    DriftSample samples[MAX_DRIFT_SAMPLES];
+    uint8_t count = configService->loadDriftSamples(samples, MAX_DRIFT_SAMPLES);
+    if (count == MAX_DRIFT_SAMPLES) {
+        memmove(samples, samples + 1, (MAX_DRIFT_SAMPLES - 1) * sizeof(DriftSample));
+        count--;
+    }
+    samples[count++] = {trueTime, interval, errorMs, agingOffset};
+    configService->saveDriftSamples(samples, count);
+
+    // Intrinsic rate with the aging register at 0, averaged over all samples
+    // weighted by their interval (= total error over total time)
+    int64_t weightedPpb = 0;
+    uint64_t totalInterval = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        int64_t measured = (int64_t)samples[i].errorMs * 1000000LL / samples[i].interval;
+        int64_t intrinsic = measured + (int64_t)samples[i].agingOffset * AGING_PPB_PER_LSB;
+        weightedPpb += intrinsic * samples[i].interval;
+        totalInterval += samples[i].interval;
+    }
+    int32_t intrinsicPpb = (int32_t)(weightedPpb / (int64_t)totalInterval);
+
+    // A fast clock needs a positive aging offset to slow it down
+    int32_t lsb = (intrinsicPpb + (intrinsicPpb >= 0 ? AGING_PPB_PER_LSB / 2 : -AGING_PPB_PER_LSB / 2)) / AGING_PPB_PER_LSB;
+    int8_t aging = (int8_t)constrain(lsb, -127, 127);
+    int32_t residual = intrinsicPpb - aging * AGING_PPB_PER_LSB;
+
+    Serial.printf("[CLOCK] Drift sample: %ld ms over %lu s -> intrinsic %ld ppb (%d samples)\n",
+                  (long)errorMs, (unsigned long)interval, (long)intrinsicPpb, count);
+
+    if (aging != agingOffset && !writeAgingOffset(aging)) {
+        // Keep the old aging value and cover everything with the residual
+        aging = agingOffset;
+        residual = intrinsicPpb - aging * AGING_PPB_PER_LSB;
+    }
+    agingOffset = aging;
+    driftResidualPpb = residual;
+    configService->setDriftCompensation(aging, residual);
+    return true;
+}
+
+bool ClockService::writeAgingOffset(int8_t value) {
+    if (!rtc.writeRegister(DS3231_REG_AGING, (uint8_t)value)) {
+        Serial.println("[CLOCK] Failed to write aging offset");
+        return false;
+    }
+
+    // The new value takes effect at the next temperature conversion -
+    // start one now instead of waiting up to 64 s. Separate write: the
+    // conversion must not start before the aging byte has landed.
+    rtc.writeRegister(DS3231_REG_CONTROL, rtc.shadow(DS3231_REG_CONTROL) | DS3231_CONV);
+
+    Serial.printf("[CLOCK] Aging offset set to %d (%+.1f ppm)\n", value, value * -0.1f);
+    return true;
 }
 
 bool ClockService::needsSync(uint32_t thresholdMs) {
@@ -118,50 +484,118 @@ bool ClockService::needsSync(uint32_t thresholdMs) {
     return (millis() - lastSyncTime) > thresholdMs;
 }
 
-bool ClockService::setAlarm(const DateTime &dt) {
+bool ClockService::setAlarm(uint8_t alarm, const DateTime &dt) {
     if (!available) {
         Serial.println("[CLOCK] Cannot set alarm - RTC not available");
         return false;
     }
+    if (alarm < 1 || alarm > ALARM_COUNT) return false;
 
-    // Clear any existing alarm
-    rtc.clearAlarm(1);
-
-    // Set Alarm1 to match date, hour, minute, second
-    if (!rtc.setAlarm1(dt, DS3231_A1_Date)) {
-        Serial.println("[CLOCK] Failed to set alarm");
+    // The RTC counts uncorrected time - undo the residual drift correction.
+    // Alarm 2 has no seconds; round up so it never fires early.
+    uint32_t rtcTime = uncorrectDrift(dt.unixtime());
+    if (alarm == 2 && rtcTime % 60 != 0) {
+        rtcTime += 60 - rtcTime % 60;
+    }
+    const DateTime rtcAlarm(rtcTime);
+
+    // One burst from the alarm's first register through status: the alarm
+    // time (Alarm1 matches date, hour, minute, second; Alarm2 date, hour,
+    // minute), Alarm 2's unchanged registers when writing Alarm 1, the
+    // control register with the interrupt enabled and the status register
+    // clearing this alarm's stale flag
+    const uint8_t first = alarm == 1 ? DS3231_REG_ALARM1 : DS3231_REG_ALARM2;
+    const uint8_t len = DS3231_REG_STATUS + 1 - first;
+    const uint8_t enable = alarm == 1 ? DS3231_A1IE : DS3231_A2IE;
+    uint8_t regs[DS3231_REG_STATUS + 1 - DS3231_REG_ALARM1];
+    memcpy(regs, rtc.shadowAt(first), len);
+    uint8_t alarmLen = Ds3231::encodeAlarm(alarm, rtcAlarm, regs);
+    regs[DS3231_REG_CONTROL - first] = (rtc.shadow(DS3231_REG_CONTROL) & ~DS3231_CONV) | DS3231_INTCN | enable;
+    regs[DS3231_REG_STATUS - first] = rtc.statusClearing(alarm == 1 ? DS3231_A1F : DS3231_A2F);
+
+    bool written = rtc.write(first, regs, len);
+    rearmAlarmInterrupt();
+    if (!written) {
+        Serial.printf("[CLOCK] Failed to set alarm %d\n", alarm);
         return false;
     }
 
-    // RTClib's setAlarm1() only checks a register bit from *before* the write,
-    // not whether the I2C write itself actually landed - read back and verify
-    // so a silently-lost write doesn't leave us believing an alarm is armed.
-    DateTime readBack = rtc.getAlarm1();
-    if (readBack.day() != dt.day() || readBack.hour() != dt.hour() ||
-        readBack.minute() != dt.minute() || readBack.second() != dt.second()) {
-        Serial.println("[CLOCK] Alarm verification failed - I2C write may have been lost");
+    // An ACK does not prove the bytes landed - read back and verify so a
+    // corrupted write doesn't leave us believing an alarm is armed
+    // (status excluded - its flags read back differently from what was written)
+    if (!rtc.read(first, len - 1) || memcmp(rtc.shadowAt(first), regs, alarmLen) != 0 ||
+        (rtc.shadow(DS3231_REG_CONTROL) & (DS3231_INTCN | enable)) != (DS3231_INTCN | enable)) {
+        Serial.printf("[CLOCK] Alarm %d verification failed - I2C write may have been lost\n", alarm);
         return false;
     }
 
-    Serial.printf("[CLOCK] Alarm set for: %04d-%02d-%02d %02d:%02d:%02d\n",
+    Serial.printf("[CLOCK] Alarm %d set for: %04d-%02d-%02d %02d:%02d:%02d UTC\n", alarm,
                   dt.year(), dt.month(), dt.day(),
-                  dt.hour(), dt.minute(), dt.second());
+                  dt.hour(), dt.minute(), alarm == 1 ? dt.second() : 0);
 
     return true;
 }
 
-bool ClockService::clearAlarm() {
+bool ClockService::clearAlarm(uint8_t alarm) {
     if (!available) return false;
+    if (alarm < 1 || alarm > ALARM_COUNT) return false;
 
-    rtc.clearAlarm(1);
-    rtc.disableAlarm(1);
-    Serial.println("[CLOCK] Alarm cleared");
+    // Control and status are adjacent - disable and clear in one write
+    uint8_t regs[2];
+    regs[0] = rtc.shadow(DS3231_REG_CONTROL) & ~(DS3231_CONV | (alarm == 1 ? DS3231_A1IE : DS3231_A2IE));
+    regs[1] = rtc.statusClearing(alarm == 1 ? DS3231_A1F : DS3231_A2F);
+    bool cleared = rtc.write(DS3231_REG_CONTROL, regs, sizeof(regs));
+    rearmAlarmInterrupt();
+    if (!cleared) return false;
 
+    Serial.printf("[CLOCK] Alarm %d cleared\n", alarm);
     return true;
 }
 
-bool ClockService::checkAlarmFlag() {
+bool ClockService::acknowledgeAlarm(uint8_t alarm) {
     if (!available) return false;
+    if (alarm < 1 || alarm > ALARM_COUNT) return false;
+
+    // Releases the INT line; a date match cannot repeat before the scheduler
+    // re-arms the channel, so there is no need to disable it as well
+    bool cleared = rtc.writeRegister(DS3231_REG_STATUS, rtc.statusClearing(alarm == 1 ? DS3231_A1F : DS3231_A2F));
+    rearmAlarmInterrupt();
+
+    return cleared;
+}
+
+uint8_t ClockService::getFiredAlarms() {
+    if (!available) return 0;
+
+    // Same burst as a time refresh, so the caller's following now(true)
+    // is served from it
+    if (!refreshCache()) return 0;
+
+    uint8_t status = rtc.shadow(DS3231_REG_STATUS);
+    uint8_t fired = 0;
+    if (status & DS3231_A1F) fired |= 0x01;
+    if (status & DS3231_A2F) fired |= 0x02;
+    return fired;
+}
 
-    return rtc.alarmFired(1);
+bool ClockService::checkAlarmFlag() {
+    // Called from every loop() iteration - only touch the I2C bus once the
+    // INT line actually asserted
+    if (!alarmInterruptPending) return false;
+    alarmInterruptPending = false;
+
+    // 0 also when the status read failed: the line is still held low and
+    // no new edge will come, so keep checking until it is released
+    uint8_t fired = getFiredAlarms();
+    if (fired == 0) rearmAlarmInterrupt();
+    return fired != 0;
+}
+
+void ClockService::rearmAlarmInterrupt() {
+    // Both alarms share the INT line: if the other flag is still set after
+    // clearing one, the line never goes high and there is no new falling
+    // edge. Keep the check pending until the line is released.
+    if (digitalRead(RTC_INT_PIN) == LOW) {
+        alarmInterruptPending = true;
+    }
 }
@@ -3,39 +3,148 @@
 
 #include <Arduino.h>
 #include <RTClib.h>
-#include <Wire.h>
+#include "Ds3231.hpp"
+#include "TimeZone.hpp"
+#include "ConfigService.hpp"
+
+// Outcome of the last sub-second sync
+enum TimeSyncState : uint8_t {
+    TIME_SYNC_NONE,
+    TIME_SYNC_PENDING,  // Waiting for its second (or for the device to be idle)
+    TIME_SYNC_DONE,     // Written, or the RTC was close enough to leave alone
+    TIME_SYNC_FAILED    // RTC write failed, or the device stayed busy too long
+};
+
+// One consistent reading of the clock, for callers that need the time and
+// its zone together (e.g. across a DST switch)
+struct ClockSnapshot {
+    DateTime utc;
+    DateTime local;
+    int32_t utcOffsetSeconds;
+    const char* timeZoneName;
+};
 
 class ClockService {
 public:
     ClockService();
 
+    // Drift samples and compensation are kept in NVS through ConfigService;
+    // without it the clock runs uncompensated
+    void setConfigService(ConfigService* config) { configService = config; }
+
     bool begin();
     bool isAvailable();
     bool isTimeTrusted();  // false if RTC missing, or lost power and not yet re-synced
 
-    // Time management
+    // Time management. The DS3231 runs on UTC; now() and every timestamp
+    // handed out or stored are UTC, local time is only for display and for
+    // compiling schedules. now() is served from a cache that is re-read from
+    // the DS3231 at most once per second and extrapolated from esp_timer in
+    // between; forceRead bypasses it (e.g. right after an alarm fired) - a
+    // reading from the last few milliseconds, such as the burst that just
+    // fetched the alarm flags, already counts as fresh.
     bool setTime(uint32_t unixTime);
-    DateTime now();
+    DateTime now(bool forceRead = false);
+
+    // Sub-second sync: utcOffsetUs maps esp_timer_get_time() to UTC in µs.
+    // The RTC is written from update() exactly on a UTC second boundary, so
+    // none of the request latency ends up in the clock. Measuring blocks
+    // loop() for up to ~1.2 s, so update() only does it while idle (no feed
+    // running or held) and otherwise moves on to a later second.
+    bool syncTime(int64_t utcOffsetUs);
+    void update(bool idle);
+    TimeSyncState getSyncState() const { return syncState; }
+
+    // Block until the RTC ticks into `utcTime` (at most ~2 s) and report the
+    // esp_timer time of the tick. False if that second has already begun -
+    // the tick was missed - or the RTC cannot be read.
+    bool waitForSecond(uint32_t utcTime, int64_t &tickUs);
+    ClockSnapshot snapshot(bool forceRead = false);
     int32_t getCurrentUtcOffsetSeconds();
     const char* getCurrentTimeZoneName();
 
+    // POSIX TZ rule, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+    bool setTimeZone(const char *posix);
+    const char* getTimeZone() const { return timeZone.getRule(); }
+
+    // Local time conversions for a UTC instant
+    int32_t getUtcOffsetAt(uint32_t utcTime) { return timeZone.utcOffsetForUtc(utcTime); }
+    uint32_t toLocal(uint32_t utcTime) { return utcTime + timeZone.utcOffsetForUtc(utcTime); }
+    uint32_t toUtc(uint32_t localTime) { return localTime - timeZone.utcOffsetForLocal(localTime); }
+    void getUtcOffsetPeriod(uint32_t utcTime, uint32_t &from, uint32_t &until) {
+        timeZone.getOffsetPeriod(utcTime, from, until);
+    }
+
+    // Firmware before UTC mode kept local time in the DS3231 - rewrite it
+    // as UTC once (the caller remembers that it was done)
+    bool convertRtcToUtc();
+
     // Check if RTC needs sync (drift > threshold)
     bool needsSync(uint32_t thresholdMs = 3000);
 
-    // Alarm management
-    bool setAlarm(const DateTime &dt);
-    bool clearAlarm();
-    bool checkAlarmFlag();
+    // Learned drift: DS3231 aging register (0.1 ppm per LSB, positive slows
+    // the oscillator) and the rate left over beyond its range, in ppb
+    int8_t getAgingOffset() const { return agingOffset; }
+    int32_t getDriftResidualPpb() const { return driftResidualPpb; }
+
+    // Alarm management - both DS3231 channels. Alarm 1 matches to the
+    // second, Alarm 2 only to the minute (seconds are ignored).
+    static const uint8_t ALARM_COUNT = 2;
+    bool setAlarm(uint8_t alarm, const DateTime &dt);
+    bool clearAlarm(uint8_t alarm);        // Clear the flag and disable the alarm
+    bool acknowledgeAlarm(uint8_t alarm);  // Clear the fired flag only, leave the alarm enabled
+    uint8_t getFiredAlarms();              // Bit 0 = Alarm 1, bit 1 = Alarm 2
+    bool checkAlarmFlag();                 // Any alarm fired - I2C only after INT asserted
+
+    const Ds3231BusStats& getBusStats() const { return rtc.getStats(); }
 
 private:
-    RTC_DS3231 rtc;
+    Ds3231 rtc;
+    ConfigService* configService = nullptr;
     bool available;
     bool timeTrusted;
     uint32_t lastSyncTime;
 
-    static uint8_t lastSundayOfMonth(uint16_t year, uint8_t month);
-    static bool isDstEuropeBerlinFromUtc(const DateTime &utcTime);
-    static bool isDstEuropeBerlinLocal(const DateTime &localTime);
+    // Time cache: the DS3231's second, an esp_timer time no earlier than
+    // the tick that started it, and when it was read
+    uint32_t cachedTime;
+    int64_t cachedAtUs;
+    int64_t cachedReadUs;
+    bool cacheValid;
+    bool refreshCache();
+    bool writeTime(uint32_t utcTime);
+    bool commitTime(uint32_t unixTime);  // Write, log and restart the drift baseline
+    // Records a drift sample if the error allows; false if the RTC is
+    // close enough to leave it running
+    bool syncNeedsWrite(uint32_t trueTime, int32_t rawErrorMs, int32_t errorMs, int32_t thresholdMs);
+    // Poll until the RTC's seconds change; false on timeout or a bus error
+    bool pollRtcTick(int64_t deadlineUs, uint32_t &tickTime, int64_t &tickUs);
+
+    // Drift compensation. rtcSetTime is the UTC time the RTC was last set;
+    // the residual is applied as a linear correction from there.
+    uint32_t rtcSetTime;
+    int8_t agingOffset;
+    int32_t driftResidualPpb;
+    int32_t driftCorrectionMs(uint32_t rawTime) const;
+    uint32_t correctDrift(uint32_t rawTime) const;
+    uint32_t uncorrectDrift(uint32_t utcTime) const;
+    bool learnDrift(int32_t errorMs, uint32_t trueTime, int32_t minErrorMs);  // True if a sample was recorded
+    bool writeAgingOffset(int8_t value);
+
+    // Pending sub-second sync: write syncSecond at esp_timer time syncAtUs
+    bool syncPending;
+    uint32_t syncSecond;
+    int64_t syncAtUs;
+    int64_t syncRequestedUs;
+    TimeSyncState syncState;
+
+    // Set from the RTC_INT_PIN interrupt (falling edge of the DS3231
+    // INT/SQW line), consumed by checkAlarmFlag()
+    static volatile bool alarmInterruptPending;
+    static void IRAM_ATTR onAlarmInterrupt();
+    void rearmAlarmInterrupt();
+
+    TimeZone timeZone;
 };
 
 #endif // CLOCK_SERVICE_HPP
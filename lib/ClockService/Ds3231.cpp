@@ -0,0 +1,125 @@
+#include "Ds3231.hpp"
+
+static const uint8_t DS3231_I2C_ADDRESS = 0x68;
+// The DS3231 supports fast mode; a 17-byte burst takes ~0.5 ms instead of ~2 ms
+static const uint32_t I2C_CLOCK_HZ = 400000;
+static const uint16_t I2C_TIMEOUT_MS = 10;
+// SCL pulses needed to let a slave finish a byte it is stuck in
+static const uint8_t BUS_CLEAR_PULSES = 9;
+
+Ds3231::Ds3231() : stats{} {
+    memset(regs, 0, sizeof(regs));
+}
+
+bool Ds3231::begin() {
+    Wire.begin(SDA, SCL, I2C_CLOCK_HZ);
+    Wire.setTimeOut(I2C_TIMEOUT_MS);
+    return read(DS3231_REG_TIME, DS3231_REG_COUNT);
+}
+
+bool Ds3231::read(uint8_t reg, uint8_t len) {
+    if (reg + len > DS3231_REG_COUNT) return false;
+    return transfer(reg, nullptr, len, true);
+}
+
+bool Ds3231::write(uint8_t reg, const uint8_t *data, uint8_t len) {
+    if (reg + len > DS3231_REG_COUNT) return false;
+    if (!transfer(reg, data, len, false)) return false;
+    memcpy(&regs[reg], data, len);
+    return true;
+}
+
+bool Ds3231::transfer(uint8_t reg, const uint8_t *data, uint8_t len, bool isRead) {
+    uint32_t start = micros();
+    bool ok = transferOnce(reg, data, len, isRead);
+    if (!ok) {
+        // A reset mid-transaction can leave the DS3231 holding SDA low,
+        // which NACKs everything until it is clocked out
+        stats.failures++;
+        recoverBus();
+        ok = transferOnce(reg, data, len, isRead);
+    }
+
+    uint32_t elapsed = micros() - start;
+    stats.transactions++;
+    stats.lastUs = elapsed;
+    stats.totalUs += elapsed;
+    if (elapsed > stats.maxUs) stats.maxUs = elapsed;
+
+    if (!ok) {
+        Serial.printf("[CLOCK] I2C %s of register 0x%02X failed\n", isRead ? "read" : "write", reg);
+    }
+    return ok;
+}
+
+bool Ds3231::transferOnce(uint8_t reg, const uint8_t *data, uint8_t len, bool isRead) {
+    Wire.beginTransmission(DS3231_I2C_ADDRESS);
+    Wire.write(reg);
+    if (!isRead) {
+        Wire.write(data, len);
+        return Wire.endTransmission() == 0;
+    }
+
+    // Repeated start, so the register pointer and the read are one transaction
+    if (Wire.endTransmission(false) != 0) return false;
+    if (Wire.requestFrom(DS3231_I2C_ADDRESS, (size_t)len) != len) return false;
+    for (uint8_t i = 0; i < len; i++) {
+        regs[reg + i] = Wire.read();
+    }
+    return true;
+}
+
+void Ds3231::recoverBus() {
+    stats.recoveries++;
+    Wire.end();
+
+    // Clock SCL until the slave releases SDA, then issue a STOP
+    pinMode(SDA, INPUT_PULLUP);
+    pinMode(SCL, OUTPUT_OPEN_DRAIN);
+    for (uint8_t i = 0; i < BUS_CLEAR_PULSES && digitalRead(SDA) == LOW; i++) {
+        digitalWrite(SCL, LOW);
+        delayMicroseconds(5);
+        digitalWrite(SCL, HIGH);
+        delayMicroseconds(5);
+    }
+    pinMode(SDA, OUTPUT_OPEN_DRAIN);
+    digitalWrite(SDA, LOW);
+    delayMicroseconds(5);
+    digitalWrite(SDA, HIGH);
+    delayMicroseconds(5);
+
+    Wire.begin(SDA, SCL, I2C_CLOCK_HZ);
+    Wire.setTimeOut(I2C_TIMEOUT_MS);
+    Serial.println("[CLOCK] I2C bus recovered");
+}
+
+DateTime Ds3231::getTime() const {
+    const uint8_t *t = &regs[DS3231_REG_TIME];
+    return DateTime(2000 + bcd2bin(t[6]), bcd2bin(t[5] & 0x7F), bcd2bin(t[4]),
+                    bcd2bin(t[2] & 0x3F), bcd2bin(t[1]), bcd2bin(t[0] & 0x7F));
+}
+
+void Ds3231::encodeTime(const DateTime &dt, uint8_t *out) {
+    out[0] = bin2bcd(dt.second());
+    out[1] = bin2bcd(dt.minute());
+    out[2] = bin2bcd(dt.hour());
+    out[3] = dt.dayOfTheWeek() == 0 ? 7 : dt.dayOfTheWeek();  // 1-7, Monday = 1
+    out[4] = bin2bcd(dt.day());
+    out[5] = bin2bcd(dt.month());
+    out[6] = bin2bcd(dt.year() - 2000);
+}
+
+uint8_t Ds3231::encodeAlarm(uint8_t alarm, const DateTime &dt, uint8_t *out) {
+    // All mask bits (bit 7) clear and DY/DT clear: match on the date
+    uint8_t len = 0;
+    if (alarm == 1) out[len++] = bin2bcd(dt.second());
+    out[len++] = bin2bcd(dt.minute());
+    out[len++] = bin2bcd(dt.hour());
+    out[len++] = bin2bcd(dt.day());
+    return len;
+}
+
+uint8_t Ds3231::statusClearing(uint8_t clearMask) const {
+    uint8_t status = (regs[DS3231_REG_STATUS] & (DS3231_OSF | DS3231_EN32KHZ)) | DS3231_A1F | DS3231_A2F;
+    return status & ~clearMask;
+}
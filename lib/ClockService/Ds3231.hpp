@@ -0,0 +1,84 @@
+#ifndef DS3231_HPP
+#define DS3231_HPP
+
+#include <Arduino.h>
+#include <RTClib.h>
+#include <Wire.h>
+
+// Register map (datasheet table 1)
+#define DS3231_REG_TIME     0x00  // 7 bytes: s, min, h, weekday, date, month, year
+#define DS3231_REG_ALARM1   0x07  // 4 bytes: s, min, h, date
+#define DS3231_REG_ALARM2   0x0B  // 3 bytes: min, h, date
+#define DS3231_REG_CONTROL  0x0E
+#define DS3231_REG_STATUS   0x0F
+#define DS3231_REG_AGING    0x10
+#define DS3231_REG_COUNT    0x11  // Everything up to and including aging
+
+// Control register
+#define DS3231_A1IE   0x01
+#define DS3231_A2IE   0x02
+#define DS3231_INTCN  0x04
+#define DS3231_CONV   0x20
+
+// Status register
+#define DS3231_A1F      0x01
+#define DS3231_A2F      0x02
+#define DS3231_EN32KHZ  0x08
+#define DS3231_OSF      0x80
+
+// Per-transaction I2C statistics, for spotting a marginal bus
+struct Ds3231BusStats {
+    uint32_t transactions;
+    uint32_t failures;    // Transactions that needed a retry
+    uint32_t recoveries;  // Bus clears after a NACK or timeout
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+};
+
+// Thin register layer over Wire. Reads and writes are bursts over a
+// contiguous register range, mirrored in a shadow copy, so a single
+// transaction can fetch time, alarms and status together and callers can
+// build writes from the last known register contents. The DS3231 has no
+// other writer, so the shadow only goes stale for the time registers and
+// the status flags - re-read those before relying on them.
+class Ds3231 {
+public:
+    Ds3231();
+
+    // Starts Wire in fast mode and reads the full register map
+    bool begin();
+
+    bool read(uint8_t reg, uint8_t len);
+    bool write(uint8_t reg, const uint8_t *data, uint8_t len);
+    bool writeRegister(uint8_t reg, uint8_t value) { return write(reg, &value, 1); }
+
+    uint8_t shadow(uint8_t reg) const { return reg < DS3231_REG_COUNT ? regs[reg] : 0; }
+    const uint8_t* shadowAt(uint8_t reg) const { return &regs[reg]; }
+
+    // Time registers <-> DateTime (24 h mode, years 2000-2099)
+    DateTime getTime() const;
+    static void encodeTime(const DateTime &dt, uint8_t *out);
+
+    // Alarm registers set to match date, hour, minute (and second for Alarm 1)
+    static uint8_t encodeAlarm(uint8_t alarm, const DateTime &dt, uint8_t *out);
+
+    // Status byte to write so only the flags in clearMask get cleared:
+    // A1F/A2F ignore a written 1, OSF and EN32kHz keep their last value
+    uint8_t statusClearing(uint8_t clearMask) const;
+
+    const Ds3231BusStats& getStats() const { return stats; }
+
+private:
+    uint8_t regs[DS3231_REG_COUNT];
+    Ds3231BusStats stats;
+
+    bool transfer(uint8_t reg, const uint8_t *data, uint8_t len, bool isRead);
+    bool transferOnce(uint8_t reg, const uint8_t *data, uint8_t len, bool isRead);
+    void recoverBus();
+
+    static uint8_t bin2bcd(uint8_t value) { return value + 6 * (value / 10); }
+    static uint8_t bcd2bin(uint8_t value) { return value - 6 * (value >> 4); }
+};
+
+#endif // DS3231_HPP
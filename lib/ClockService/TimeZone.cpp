@@ -0,0 +1,246 @@
+#include "TimeZone.hpp"
+
+static const uint32_t SECONDS_PER_DAY = 86400;
+
+TimeZone::TimeZone()
+    : stdOffset(0), dstOffset(0), hasDst(false), dstStart{}, dstEnd{},
+      cachedYear(-1), yearStart(0), yearEnd(0), dstStartUtc(0), dstEndUtc(0) {
+    rule[0] = '\0';
+    strcpy(stdName, "UTC");
+    dstName[0] = '\0';
+    set(DEFAULT_TIME_ZONE);
+}
+
+bool TimeZone::set(const char *posix) {
+    TimeZone parsed(*this);
+    if (!parse(posix, parsed)) return false;
+
+    *this = parsed;
+    strncpy(rule, posix, TIME_ZONE_MAX_LEN);
+    rule[TIME_ZONE_MAX_LEN] = '\0';
+    cachedYear = -1;
+    return true;
+}
+
+bool TimeZone::isValid(const char *posix) {
+    TimeZone scratch;
+    return parse(posix, scratch);
+}
+
+int32_t TimeZone::utcOffsetForUtc(uint32_t utcTime) {
+    return isDstUtc(utcTime) ? dstOffset : stdOffset;
+}
+
+int32_t TimeZone::utcOffsetForLocal(uint32_t localTime) {
+    return isDstLocal(localTime) ? dstOffset : stdOffset;
+}
+
+bool TimeZone::isDstUtc(uint32_t utcTime) {
+    if (!hasDst) return false;
+    cacheYearOf(utcTime);
+    return inDst(dstStartUtc, dstEndUtc, utcTime, 0);
+}
+
+bool TimeZone::isDstLocal(uint32_t localTime) {
+    if (!hasDst) return false;
+    cacheYearOf(localTime);
+    // Both switches happen at UTC instant + DST offset on the wall clock
+    return inDst(dstStartUtc, dstEndUtc, localTime, dstOffset);
+}
+
+void TimeZone::getOffsetPeriod(uint32_t utcTime, uint32_t &from, uint32_t &until) {
+    from = 0;
+    until = 0;
+    if (!hasDst) return;
+
+    cacheYearOf(utcTime);
+
+    // Transitions of the previous, current and next year in order; a
+    // period never spans more than that
+    uint32_t transitions[6];
+    for (int8_t y = -1; y <= 1; y++) {
+        if (cachedYear + y < 1970) {
+            transitions[(y + 1) * 2] = transitions[(y + 1) * 2 + 1] = 0;
+            continue;
+        }
+        uint32_t a = transitionUtc(cachedYear + y, dstStart, stdOffset);
+        uint32_t b = transitionUtc(cachedYear + y, dstEnd, dstOffset);
+        transitions[(y + 1) * 2] = a < b ? a : b;
+        transitions[(y + 1) * 2 + 1] = a < b ? b : a;
+    }
+
+    for (uint8_t i = 0; i < 6; i++) {
+        if (transitions[i] <= utcTime) {
+            from = transitions[i];
+        } else {
+            until = transitions[i];
+            break;
+        }
+    }
+}
+
+bool TimeZone::inDst(uint32_t utcStart, uint32_t utcEnd, uint32_t time, int32_t shift) const {
+    uint32_t start = utcStart + shift;
+    uint32_t end = utcEnd + shift;
+    if (start < end) {
+        return time >= start && time < end;
+    }
+    // Southern hemisphere: DST spans the new year
+    return time >= start || time < end;
+}
+
+void TimeZone::cacheYearOf(uint32_t time) {
+    if (cachedYear >= 0 && time >= yearStart && time < yearEnd) return;
+
+    int32_t year = yearOfDays(time / SECONDS_PER_DAY);
+    cachedYear = year;
+    yearStart = (uint32_t)daysFromCivil(year, 1, 1) * SECONDS_PER_DAY;
+    yearEnd = (uint32_t)daysFromCivil(year + 1, 1, 1) * SECONDS_PER_DAY;
+    dstStartUtc = transitionUtc(year, dstStart, stdOffset);
+    dstEndUtc = transitionUtc(year, dstEnd, dstOffset);
+}
+
+uint32_t TimeZone::transitionUtc(int32_t year, const TimeZoneTransition &t, int32_t offsetBefore) const {
+    static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    int32_t first = daysFromCivil(year, t.month, 1);
+    uint8_t length = daysInMonth[t.month - 1];
+    if (t.month == 2 && (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))) length = 29;
+
+    // 1970-01-01 (day 0) was a Thursday
+    uint8_t firstWeekday = (first + 4) % 7;
+    int32_t day = 1 + (t.weekday + 7 - firstWeekday) % 7 + (t.week - 1) * 7;
+    while (day > length) day -= 7;  // Week 5 = last one in the month
+
+    return (uint32_t)((int64_t)(first + day - 1) * SECONDS_PER_DAY + t.time - offsetBefore);
+}
+
+bool TimeZone::parse(const char *posix, TimeZone &tz) {
+    if (!posix || strlen(posix) == 0 || strlen(posix) > TIME_ZONE_MAX_LEN) return false;
+
+    const char *p = parseName(posix, tz.stdName);
+    if (!p) return false;
+
+    // POSIX offsets count west of UTC ("CET-1" is UTC+1)
+    int32_t west;
+    p = parseOffset(p, west);
+    if (!p) return false;
+    tz.stdOffset = -west;
+
+    tz.hasDst = *p != '\0';
+    if (!tz.hasDst) {
+        tz.dstName[0] = '\0';
+        tz.dstOffset = tz.stdOffset;
+        return true;
+    }
+
+    p = parseName(p, tz.dstName);
+    if (!p) return false;
+
+    tz.dstOffset = tz.stdOffset + 3600;
+    if (*p != ',' && *p != '\0') {
+        p = parseOffset(p, west);
+        if (!p) return false;
+        tz.dstOffset = -west;
+    }
+
+    // Only the Mm.w.d form - no built-in default rules
+    if (*p != ',') return false;
+    p = parseTransition(p + 1, tz.dstStart);
+    if (!p || *p != ',') return false;
+    p = parseTransition(p + 1, tz.dstEnd);
+    return p && *p == '\0';
+}
+
+const char* TimeZone::parseName(const char *p, char *name) {
+    uint8_t len = 0;
+    if (*p == '<') {
+        // Quoted form, e.g. <+03>
+        p++;
+        while (*p && *p != '>') {
+            if (len >= TIME_ZONE_NAME_LEN - 1) return nullptr;
+            name[len++] = *p++;
+        }
+        if (*p != '>') return nullptr;
+        p++;
+    } else {
+        while (isalpha((unsigned char)*p)) {
+            if (len >= TIME_ZONE_NAME_LEN - 1) return nullptr;
+            name[len++] = *p++;
+        }
+    }
+    name[len] = '\0';
+    return len >= 3 ? p : nullptr;
+}
+
+const char* TimeZone::parseOffset(const char *p, int32_t &seconds) {
+    int32_t sign = 1;
+    if (*p == '+' || *p == '-') {
+        if (*p == '-') sign = -1;
+        p++;
+    }
+
+    // hh[:mm[:ss]]
+    int32_t parts[3] = {0, 0, 0};
+    for (uint8_t i = 0; i < 3; i++) {
+        if (!isdigit((unsigned char)*p)) return nullptr;
+        int32_t value = 0;
+        uint8_t digits = 0;
+        while (isdigit((unsigned char)*p) && digits < 3) {
+            value = value * 10 + (*p++ - '0');
+            digits++;
+        }
+        parts[i] = value;
+        if (*p != ':') break;
+        p++;
+    }
+
+    if (parts[0] > 167 || parts[1] > 59 || parts[2] > 59) return nullptr;
+    seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+    return p;
+}
+
+const char* TimeZone::parseTransition(const char *p, TimeZoneTransition &t) {
+    if (*p++ != 'M') return nullptr;
+
+    int32_t fields[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        if (!isdigit((unsigned char)*p)) return nullptr;
+        fields[i] = 0;
+        while (isdigit((unsigned char)*p)) fields[i] = fields[i] * 10 + (*p++ - '0');
+        if (i < 2 && *p++ != '.') return nullptr;
+    }
+    if (fields[0] < 1 || fields[0] > 12 || fields[1] < 1 || fields[1] > 5 || fields[2] > 6) {
+        return nullptr;
+    }
+
+    t.month = fields[0];
+    t.week = fields[1];
+    t.weekday = fields[2];
+    t.time = 2 * 3600;  // POSIX default 02:00
+
+    if (*p == '/') {
+        p = parseOffset(p + 1, t.time);
+    }
+    return p;
+}
+
+int32_t TimeZone::daysFromCivil(int32_t year, uint8_t month, uint8_t day) {
+    // Days since 1970-01-01 (proleptic Gregorian), H. Hinnant's algorithm
+    year -= month <= 2;
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yoe = (uint32_t)(year - era * 400);
+    const uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+int32_t TimeZone::yearOfDays(int32_t days) {
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t doe = (uint32_t)(days - era * 146097);
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const uint32_t mp = (5 * doy + 2) / 153;
+    return (int32_t)yoe + era * 400 + (mp >= 10 ? 1 : 0);
+}
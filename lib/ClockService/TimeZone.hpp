@@ -0,0 +1,80 @@
+#ifndef TIME_ZONE_HPP
+#define TIME_ZONE_HPP
+
+#include <Arduino.h>
+
+#define TIME_ZONE_MAX_LEN 48
+#define TIME_ZONE_NAME_LEN 8
+#define DEFAULT_TIME_ZONE "CET-1CEST,M3.5.0,M10.5.0/3"  // Europe/Berlin
+
+// A POSIX TZ transition of the form Mm.w.d[/time]: weekday d (0 = Sunday)
+// of week w (1-4, 5 = last) of month m, at `time` seconds of local wall
+// clock time in the offset that is in effect before the switch.
+struct TimeZoneTransition {
+    uint8_t month;
+    uint8_t week;
+    uint8_t weekday;
+    int32_t time;
+};
+
+// POSIX TZ rule (e.g. "CET-1CEST,M3.5.0,M10.5.0/3", "JST-9", "<+03>-3").
+// The two transitions are computed once per year and cached, after which
+// an offset lookup is a range check plus two integer comparisons.
+class TimeZone {
+public:
+    TimeZone();
+
+    // Parse and apply a rule; leaves the current rule untouched on error
+    bool set(const char *posix);
+    const char* getRule() const { return rule; }
+
+    // Offsets in seconds east of UTC (CET = +3600)
+    int32_t utcOffsetForUtc(uint32_t utcTime);
+    int32_t utcOffsetForLocal(uint32_t localTime);
+
+    bool isDstUtc(uint32_t utcTime);
+    // Wall clock time. The hour skipped in spring counts as standard time,
+    // the repeated hour in autumn as daylight time.
+    bool isDstLocal(uint32_t localTime);
+
+    const char* getName(bool dst) const { return dst ? dstName : stdName; }
+
+    // UTC span [from, until) around `utcTime` in which the offset stays
+    // constant; 0 for an open end (no DST at all)
+    void getOffsetPeriod(uint32_t utcTime, uint32_t &from, uint32_t &until);
+
+    // Syntax check only - for validating input before storing it
+    static bool isValid(const char *posix);
+
+private:
+    char rule[TIME_ZONE_MAX_LEN + 1];
+    char stdName[TIME_ZONE_NAME_LEN];
+    char dstName[TIME_ZONE_NAME_LEN];
+    int32_t stdOffset;
+    int32_t dstOffset;
+    bool hasDst;
+    TimeZoneTransition dstStart;
+    TimeZoneTransition dstEnd;
+
+    // Transition instants (UTC) for the cached year, which spans
+    // [yearStart, yearEnd) in whatever time base it was looked up with
+    int32_t cachedYear;
+    uint32_t yearStart;
+    uint32_t yearEnd;
+    uint32_t dstStartUtc;
+    uint32_t dstEndUtc;
+
+    void cacheYearOf(uint32_t time);
+    bool inDst(uint32_t utcStart, uint32_t utcEnd, uint32_t time, int32_t shift) const;
+    uint32_t transitionUtc(int32_t year, const TimeZoneTransition &t, int32_t offsetBefore) const;
+
+    static bool parse(const char *posix, TimeZone &tz);
+    static const char* parseName(const char *p, char *name);
+    static const char* parseOffset(const char *p, int32_t &seconds);
+    static const char* parseTransition(const char *p, TimeZoneTransition &t);
+
+    static int32_t daysFromCivil(int32_t year, uint8_t month, uint8_t day);
+    static int32_t yearOfDays(int32_t days);
+};
+
+#endif // TIME_ZONE_HPP
@@ -1,8 +1,36 @@
 #include "ConfigService.hpp"
-#include "FeedingService.hpp"  // For FeedHistoryEntry definition
-
-ConfigService::ConfigService() : portionUnitGrams(12), manualPortionUnits(1),
-    vibrationEnabled(true), vibrationPulseSeconds(3) {}
+#include "FeedingService.hpp"  // For FeedMetrics definition
+#include <esp_rom_crc.h>
+
+static void defaultSchedule(uint8_t index, Schedule &schedule);
+
+// Keys written behind, one bit each
+enum ConfigDirtyBit : uint16_t {
+    DIRTY_PORTION_GRAMS = 1 << 0,
+    DIRTY_MANUAL_UNITS = 1 << 1,
+    DIRTY_BATCH_WINDOW = 1 << 2,
+    DIRTY_SERVO_ANGLES = 1 << 3,
+    DIRTY_OPEN_DWELL = 1 << 4,
+    DIRTY_PORTION_GAP = 1 << 5,
+    DIRTY_BARRIER_PULSES = 1 << 6,
+    DIRTY_VIBRATION_ENABLED = 1 << 7,
+    DIRTY_VIBRATION_PULSE = 1 << 8,
+    DIRTY_VIBRATION_PATTERN = 1 << 9,
+    DIRTY_PRE_AGITATION = 1 << 10,
+    DIRTY_FEED_HISTORY = 1 << 11
+};
+
+ConfigService::ConfigService() : portionUnitGrams(12), manualPortionUnits(1), batchWindowMinutes(0),
+    servoCloseAngle(DEFAULT_SERVO_CLOSE_ANGLE), servoOpenAngle(DEFAULT_SERVO_OPEN_ANGLE),
+    openDwellMs(DEFAULT_OPEN_DWELL_MS), portionGapMs(DEFAULT_PORTION_GAP_MS), barrierPulsesPerPortion(0), vibrationEnabled(true), vibrationPulseSeconds(3),
+    vibrationPattern(0), preAgitationMs(DEFAULT_PRE_AGITATION_MS), scheduleGeneration(0), rtcUtc(false),
+    rtcSetTime(0), agingOffset(0), driftResidualPpb(0), schedulesValid(true), generation(0), dirty(0), firstDirtyMs(0), lastChangeMs(0),
+    pendingHistorySize(0) {
+    strcpy(timeZone, DEFAULT_TIME_ZONE);
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        defaultSchedule(i, schedules[i]);
+    }
+}
 
 bool ConfigService::begin() {
     preferences.begin("feeder", false);
@@ -10,22 +38,167 @@ bool ConfigService::begin() {
     // Load portion unit grams
     portionUnitGrams = preferences.getUChar("portionGrams", 12);
     manualPortionUnits = preferences.getUChar("manualUnits", 1);
+    batchWindowMinutes = preferences.getUChar("batchWinMin", 0);
+    String tz = preferences.getString("tz", DEFAULT_TIME_ZONE);
+    strncpy(timeZone, tz.c_str(), TIME_ZONE_MAX_LEN);
+    timeZone[TIME_ZONE_MAX_LEN] = '\0';
+    rtcUtc = preferences.getBool("rtcUtc", false);
+    rtcSetTime = preferences.getUInt("rtcSetAt", 0);
+    agingOffset = preferences.getChar("agingOff", 0);
+    driftResidualPpb = preferences.getInt("driftPpb", 0);
+
+    // Load servo calibration; a pair that doesn't validate falls back to full travel
+    servoCloseAngle = preferences.getUChar("srvClose", DEFAULT_SERVO_CLOSE_ANGLE);
+    servoOpenAngle = preferences.getUChar("srvOpen", DEFAULT_SERVO_OPEN_ANGLE);
+    if (servoOpenAngle > 180 || servoOpenAngle < servoCloseAngle + MIN_SERVO_TRAVEL_DEG) {
+        servoCloseAngle = DEFAULT_SERVO_CLOSE_ANGLE;
+        servoOpenAngle = DEFAULT_SERVO_OPEN_ANGLE;
+    }
+    openDwellMs = preferences.getUShort("dwellMs", DEFAULT_OPEN_DWELL_MS);
+    portionGapMs = preferences.getUShort("gapMs", DEFAULT_PORTION_GAP_MS);
+    barrierPulsesPerPortion = preferences.getUChar("lbPulses", 0);
 
     // Load vibration motor config
     vibrationEnabled = preferences.getBool("vibEnabled", true);
     vibrationPulseSeconds = preferences.getUChar("vibPulseSec", 3);
+    vibrationPattern = preferences.getUChar("vibPattern", 0);
+    preAgitationMs = preferences.getUShort("vibPreMs", DEFAULT_PRE_AGITATION_MS);
+
+    scheduleGeneration = preferences.getUInt("schedGen", 0);
+    migrateSchedules();
+    schedulesValid = readSchedules(schedules);
+    generation = esp_random();
 
     Serial.println("[CONFIG] ConfigService initialized");
     Serial.printf("[CONFIG] Portion unit: %d grams\n", portionUnitGrams);
     Serial.printf("[CONFIG] Manual feed amount: %d units\n", manualPortionUnits);
-    Serial.printf("[CONFIG] Vibration: enabled=%d, pulse=%ds\n",
-                  vibrationEnabled, vibrationPulseSeconds);
+    Serial.printf("[CONFIG] Wake batching window: %d minutes\n", batchWindowMinutes);
+    Serial.printf("[CONFIG] Time zone: %s\n", timeZone);
+    Serial.printf("[CONFIG] Servo: close=%d, open=%d, dwell=%dms, gap=%dms\n",
+                  servoCloseAngle, servoOpenAngle, openDwellMs, portionGapMs);
+    Serial.printf("[CONFIG] Light barrier: %d pulses per portion\n", barrierPulsesPerPortion);
+    Serial.printf("[CONFIG] Vibration: enabled=%d, pulse=%ds, pattern=%d, pre-agitation=%dms\n",
+                  vibrationEnabled, vibrationPulseSeconds, vibrationPattern, preAgitationMs);
 
     return true;
 }
 
-void ConfigService::getScheduleKey(uint8_t index, char *key) {
-    snprintf(key, 16, "sched_%d", index);
+// All schedules in one NVS blob ("schedules"). A changed layout gets a
+// new version; a blob that fails the CRC is not used.
+#define SCHEDULE_BLOB_VERSION 1
+
+struct StoredSchedule {
+    uint8_t id;
+    uint8_t enabled;
+    uint16_t minuteOfDay;
+    uint8_t weekdayMask;
+    uint8_t portionUnits;
+};
+
+struct ScheduleBlob {
+    uint8_t version;
+    uint8_t count;
+    StoredSchedule schedules[MAX_SCHEDULES];
+    uint32_t crc;  // Over everything above
+};
+
+static uint32_t scheduleBlobCrc(const ScheduleBlob &blob) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&blob, offsetof(ScheduleBlob, crc));
+}
+
+static void defaultSchedule(uint8_t index, Schedule &schedule) {
+    schedule.id = index + 1;
+    schedule.enabled = false;
+    strncpy(schedule.time, "00:00", 6);
+    schedule.weekday_mask = 0;
+    schedule.portion_units = 1;
+}
+
+bool parseScheduleTime(const char *time, uint16_t &minuteOfDay) {
+    if (strlen(time) != 5 || time[2] != ':' ||
+        !isdigit((unsigned char)time[0]) || !isdigit((unsigned char)time[1]) ||
+        !isdigit((unsigned char)time[3]) || !isdigit((unsigned char)time[4])) {
+        return false;
+    }
+    uint8_t hour = (time[0] - '0') * 10 + (time[1] - '0');
+    uint8_t minute = (time[3] - '0') * 10 + (time[4] - '0');
+    if (hour > 23 || minute > 59) return false;
+    minuteOfDay = hour * 60 + minute;
+    return true;
+}
+
+void formatScheduleTime(uint16_t minuteOfDay, char time[6]) {
+    snprintf(time, 6, "%02u:%02u", (minuteOfDay / 60) % 24, minuteOfDay % 60);
+}
+
+bool ConfigService::readSchedules(Schedule out[MAX_SCHEDULES]) {
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        defaultSchedule(i, out[i]);
+    }
+    if (!preferences.isKey("schedules")) return true;
+
+    ScheduleBlob blob;
+    if (preferences.getBytes("schedules", &blob, sizeof(blob)) != sizeof(blob) ||
+        blob.version != SCHEDULE_BLOB_VERSION || blob.count != MAX_SCHEDULES ||
+        blob.crc != scheduleBlobCrc(blob)) {
+        Serial.println("[CONFIG] Stored schedules are corrupt or of an unknown version");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        const StoredSchedule &stored = blob.schedules[i];
+        out[i].id = stored.id;
+        out[i].enabled = stored.enabled;
+        formatScheduleTime(stored.minuteOfDay, out[i].time);
+        out[i].weekday_mask = stored.weekdayMask;
+        out[i].portion_units = stored.portionUnits;
+    }
+    return true;
+}
+
+bool ConfigService::loadAllSchedules(Schedule out[MAX_SCHEDULES]) {
+    memcpy(out, schedules, sizeof(schedules));
+    return schedulesValid;
+}
+
+static bool sameSchedule(const Schedule &a, const Schedule &b) {
+    return a.id == b.id && a.enabled == b.enabled && strcmp(a.time, b.time) == 0 &&
+           a.weekday_mask == b.weekday_mask && a.portion_units == b.portion_units;
+}
+
+bool ConfigService::saveAllSchedules(const Schedule updated[MAX_SCHEDULES]) {
+    // Unchanged: no write, and the compiled week stays valid
+    uint8_t same = 0;
+    while (schedulesValid && same < MAX_SCHEDULES && sameSchedule(updated[same], schedules[same])) same++;
+    if (same == MAX_SCHEDULES) return true;
+
+    ScheduleBlob blob;
+    memset(&blob, 0, sizeof(blob));  // Padding is part of the CRC
+    blob.version = SCHEDULE_BLOB_VERSION;
+    blob.count = MAX_SCHEDULES;
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        StoredSchedule &stored = blob.schedules[i];
+        if (!parseScheduleTime(updated[i].time, stored.minuteOfDay)) {
+            Serial.printf("[CONFIG] Invalid time in schedule %d: %s\n", i, updated[i].time);
+            return false;
+        }
+        stored.id = updated[i].id;
+        stored.enabled = updated[i].enabled;
+        stored.weekdayMask = updated[i].weekday_mask;
+        stored.portionUnits = updated[i].portion_units;
+    }
+    blob.crc = scheduleBlobCrc(blob);
+
+    if (preferences.putBytes("schedules", &blob, sizeof(blob)) != sizeof(blob)) {
+        Serial.println("[CONFIG] Saving schedules failed");
+        return false;
+    }
+    memcpy(schedules, updated, sizeof(schedules));
+    schedulesValid = true;
+    bumpGeneration();
+    preferences.putUInt("schedGen", ++scheduleGeneration);
+    Serial.printf("[CONFIG] Saved %d schedules (%d bytes)\n", MAX_SCHEDULES, sizeof(blob));
+    return true;
 }
 
 bool ConfigService::loadSchedule(uint8_t index, Schedule &schedule) {
@@ -34,37 +207,39 @@ bool ConfigService::loadSchedule(uint8_t index, Schedule &schedule) {
         return false;
     }
 
-    char key[16];
-    getScheduleKey(index, key);
+    schedule = schedules[index];
+    return schedulesValid;
+}
 
-    // Check if key exists first (avoids NVS error log)
-    if (!preferences.isKey(key)) {
-        // Return default schedule
-        schedule.id = index + 1;
-        schedule.enabled = false;
-        strncpy(schedule.time, "00:00", 6);
-        schedule.weekday_mask = 0;
-        schedule.portion_units = 1;
-        return true;
+bool ConfigService::saveSchedule(uint8_t index, const Schedule &schedule) {
+    if (index >= MAX_SCHEDULES) {
+        Serial.printf("[CONFIG] Invalid schedule index: %d\n", index);
+        return false;
     }
 
-    // Load schedule as JSON string
-    String jsonStr = preferences.getString(key, "");
+    // A corrupt blob is replaced, the other slots keeping their defaults
+    Schedule updated[MAX_SCHEDULES];
+    memcpy(updated, schedules, sizeof(updated));
+    updated[index] = schedule;
+    return saveAllSchedules(updated);
+}
+
+void ConfigService::getScheduleKey(uint8_t index, char *key) {
+    snprintf(key, 16, "sched_%d", index);
+}
 
+bool ConfigService::loadLegacySchedule(uint8_t index, Schedule &schedule) {
+    char key[16];
+    getScheduleKey(index, key);
+
+    String jsonStr = preferences.isKey(key) ? preferences.getString(key, "") : String();
     if (jsonStr.isEmpty()) {
-        // Return default schedule
-        schedule.id = index + 1;
-        schedule.enabled = false;
-        strncpy(schedule.time, "00:00", 6);
-        schedule.weekday_mask = 0;
-        schedule.portion_units = 1;
+        defaultSchedule(index, schedule);
         return true;
     }
 
-    // Parse JSON
     JsonDocument doc;
     DeserializationError error = deserializeJson(doc, jsonStr);
-
     if (error) {
         Serial.printf("[CONFIG] Failed to parse schedule %d: %s\n", index, error.c_str());
         return false;
@@ -76,55 +251,123 @@ bool ConfigService::loadSchedule(uint8_t index, Schedule &schedule) {
     schedule.time[sizeof(schedule.time) - 1] = '\0';
     schedule.weekday_mask = doc["weekday_mask"] | 0;
     schedule.portion_units = doc["portion_units"] | 1;
-
     return true;
 }
 
-bool ConfigService::saveSchedule(uint8_t index, const Schedule &schedule) {
-    if (index >= MAX_SCHEDULES) {
-        Serial.printf("[CONFIG] Invalid schedule index: %d\n", index);
-        return false;
-    }
-
+void ConfigService::migrateSchedules() {
+    // Firmware before the blob kept one JSON string per schedule
     char key[16];
-    getScheduleKey(index, key);
+    bool found = false;
+    for (uint8_t i = 0; i < MAX_SCHEDULES && !found; i++) {
+        getScheduleKey(i, key);
+        found = preferences.isKey(key);
+    }
+    if (!found || preferences.isKey("schedules")) return;
 
-    // Create JSON document
-    JsonDocument doc;
-    doc["id"] = schedule.id;
-    doc["enabled"] = schedule.enabled;
-    doc["time"] = schedule.time;
-    doc["weekday_mask"] = schedule.weekday_mask;
-    doc["portion_units"] = schedule.portion_units;
+    Schedule legacy[MAX_SCHEDULES];
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        uint16_t minuteOfDay;
+        if (!loadLegacySchedule(i, legacy[i]) || !parseScheduleTime(legacy[i].time, minuteOfDay)) {
+            // Unreadable: disabled, the way a failed load used to leave it
+            defaultSchedule(i, legacy[i]);
+        }
+    }
+    // Same schedules, so the generation (and any compiled week) stays valid
+    uint32_t savedGeneration = scheduleGeneration;
+    if (!saveAllSchedules(legacy)) return;
+    scheduleGeneration = savedGeneration;
+    preferences.putUInt("schedGen", scheduleGeneration);
 
-    // Serialize to string
-    String jsonStr;
-    serializeJson(doc, jsonStr);
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        getScheduleKey(i, key);
+        preferences.remove(key);
+    }
+    Serial.println("[CONFIG] Migrated schedules from JSON to the binary blob");
+}
 
-    // Save to preferences
-    preferences.putString(key, jsonStr);
+void ConfigService::markDirty(uint16_t bits) {
+    unsigned long now = millis();
+    portENTER_CRITICAL(&dirtyMux);
+    // Feed history is data, not configuration
+    if (bits & ~DIRTY_FEED_HISTORY) generation++;
 
-    Serial.printf("[CONFIG] Saved schedule %d: %s\n", index, jsonStr.c_str());
+    if (dirty == 0) firstDirtyMs = now;
+    dirty |= bits;
+    lastChangeMs = now;
+    portEXIT_CRITICAL(&dirtyMux);
+}
 
-    return true;
+void ConfigService::bumpGeneration() {
+    portENTER_CRITICAL(&dirtyMux);
+    generation++;
+    portEXIT_CRITICAL(&dirtyMux);
 }
 
-bool ConfigService::loadAllSchedules(Schedule schedules[MAX_SCHEDULES]) {
-    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
-        if (!loadSchedule(i, schedules[i])) {
-            return false;
-        }
+void ConfigService::update(bool idle) {
+    if (!idle) return;
+
+    unsigned long now = millis();
+    portENTER_CRITICAL(&dirtyMux);
+    bool pending = dirty != 0;
+    unsigned long settledMs = now - lastChangeMs;
+    unsigned long waitingMs = now - firstDirtyMs;
+    portEXIT_CRITICAL(&dirtyMux);
+
+    // Settled, or changing so often that it would never settle
+    if (pending && (settledMs >= CONFIG_FLUSH_SETTLE_MS || waitingMs >= CONFIG_FLUSH_DEADLINE_MS)) {
+        flush();
     }
-    return true;
 }
 
-bool ConfigService::saveAllSchedules(const Schedule schedules[MAX_SCHEDULES]) {
-    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
-        if (!saveSchedule(i, schedules[i])) {
-            return false;
+bool ConfigService::flush() {
+    // Take the pending keys. A setter that runs while they are written
+    // marks its key again, with its own time, rather than being cleared
+    // along with a value it didn't write.
+    portENTER_CRITICAL(&dirtyMux);
+    uint16_t pending = dirty;
+    unsigned long pendingSinceMs = firstDirtyMs;
+    dirty = 0;
+    portEXIT_CRITICAL(&dirtyMux);
+    if (pending == 0) return true;
+
+    // put*() returns the bytes written, 0 on failure; a failed key stays
+    // dirty for the next flush
+    uint16_t failed = 0;
+    auto check = [&failed](size_t written, uint16_t bit) {
+        if (written == 0) failed |= bit;
+    };
+    if (pending & DIRTY_PORTION_GRAMS) check(preferences.putUChar("portionGrams", portionUnitGrams), DIRTY_PORTION_GRAMS);
+    if (pending & DIRTY_MANUAL_UNITS) check(preferences.putUChar("manualUnits", manualPortionUnits), DIRTY_MANUAL_UNITS);
+    if (pending & DIRTY_BATCH_WINDOW) check(preferences.putUChar("batchWinMin", batchWindowMinutes), DIRTY_BATCH_WINDOW);
+    if (pending & DIRTY_SERVO_ANGLES) {
+        check(preferences.putUChar("srvClose", servoCloseAngle), DIRTY_SERVO_ANGLES);
+        check(preferences.putUChar("srvOpen", servoOpenAngle), DIRTY_SERVO_ANGLES);
+    }
+    if (pending & DIRTY_OPEN_DWELL) check(preferences.putUShort("dwellMs", openDwellMs), DIRTY_OPEN_DWELL);
+    if (pending & DIRTY_PORTION_GAP) check(preferences.putUShort("gapMs", portionGapMs), DIRTY_PORTION_GAP);
+    if (pending & DIRTY_BARRIER_PULSES) check(preferences.putUChar("lbPulses", barrierPulsesPerPortion), DIRTY_BARRIER_PULSES);
+    if (pending & DIRTY_VIBRATION_ENABLED) check(preferences.putBool("vibEnabled", vibrationEnabled), DIRTY_VIBRATION_ENABLED);
+    if (pending & DIRTY_VIBRATION_PULSE) check(preferences.putUChar("vibPulseSec", vibrationPulseSeconds), DIRTY_VIBRATION_PULSE);
+    if (pending & DIRTY_VIBRATION_PATTERN) check(preferences.putUChar("vibPattern", vibrationPattern), DIRTY_VIBRATION_PATTERN);
+    if (pending & DIRTY_PRE_AGITATION) check(preferences.putUShort("vibPreMs", preAgitationMs), DIRTY_PRE_AGITATION);
+    if (pending & DIRTY_FEED_HISTORY) {
+        check(preferences.putBytes("feedPack", pendingHistory, pendingHistorySize), DIRTY_FEED_HISTORY);
+        if (preferences.isKey("feedHist")) {
+            preferences.remove("feedHist");
+            preferences.remove("feedHistCnt");
+            preferences.remove("feedHistIdx");
         }
     }
-    return true;
+
+    Serial.printf("[CONFIG] Flushed pending settings 0x%03X%s\n", pending, failed ? " (some failed)" : "");
+    if (failed) {
+        portENTER_CRITICAL(&dirtyMux);
+        // Still pending since before this flush, so retried at the deadline
+        firstDirtyMs = pendingSinceMs;
+        dirty |= failed;
+        portEXIT_CRITICAL(&dirtyMux);
+    }
+    return failed == 0;
 }
 
 uint8_t ConfigService::getPortionUnitGrams() {
@@ -132,8 +375,10 @@ uint8_t ConfigService::getPortionUnitGrams() {
 }
 
 void ConfigService::setPortionUnitGrams(uint8_t grams) {
-    portionUnitGrams = grams;
-    preferences.putUChar("portionGrams", grams);
+    if (grams != portionUnitGrams) {
+        portionUnitGrams = grams;
+        markDirty(DIRTY_PORTION_GRAMS);
+    }
     Serial.printf("[CONFIG] Portion unit updated to %d grams\n", grams);
 }
 
@@ -142,18 +387,161 @@ uint8_t ConfigService::getManualPortionUnits() {
 }
 
 void ConfigService::setManualPortionUnits(uint8_t units) {
-    manualPortionUnits = units;
-    preferences.putUChar("manualUnits", units);
+    if (units != manualPortionUnits) {
+        manualPortionUnits = units;
+        markDirty(DIRTY_MANUAL_UNITS);
+    }
     Serial.printf("[CONFIG] Manual feed amount updated to %d units\n", units);
 }
 
+uint8_t ConfigService::getBatchWindowMinutes() {
+    return batchWindowMinutes;
+}
+
+void ConfigService::setBatchWindowMinutes(uint8_t minutes) {
+    if (minutes > MAX_BATCH_WINDOW_MINUTES) minutes = MAX_BATCH_WINDOW_MINUTES;
+    if (minutes != batchWindowMinutes) {
+        batchWindowMinutes = minutes;
+        markDirty(DIRTY_BATCH_WINDOW);
+    }
+    Serial.printf("[CONFIG] Wake batching window updated to %d minutes\n", minutes);
+}
+
+const char* ConfigService::getTimeZone() {
+    return timeZone;
+}
+
+void ConfigService::setTimeZone(const char *posix) {
+    if (strcmp(posix, timeZone) == 0) return;
+
+    strncpy(timeZone, posix, TIME_ZONE_MAX_LEN);
+    timeZone[TIME_ZONE_MAX_LEN] = '\0';
+    bumpGeneration();
+    preferences.putString("tz", timeZone);
+    preferences.putUInt("schedGen", ++scheduleGeneration);
+    Serial.printf("[CONFIG] Time zone updated to %s\n", timeZone);
+}
+
+bool ConfigService::isRtcUtc() {
+    return rtcUtc;
+}
+
+void ConfigService::setRtcUtc(bool utc) {
+    if (utc == rtcUtc) return;
+    rtcUtc = utc;
+    preferences.putBool("rtcUtc", utc);
+}
+
+uint8_t ConfigService::loadDriftSamples(DriftSample* samples, uint8_t maxCount) {
+    uint8_t count = preferences.getUChar("driftCnt", 0);
+    if (count > maxCount) count = maxCount;
+    if (count == 0) return 0;
+
+    size_t expectedSize = count * sizeof(DriftSample);
+    if (preferences.getBytes("driftSmp", samples, expectedSize) != expectedSize) {
+        Serial.println("[CONFIG] Drift sample size mismatch - discarding");
+        return 0;
+    }
+    return count;
+}
+
+bool ConfigService::saveDriftSamples(const DriftSample* samples, uint8_t count) {
+    if (count > MAX_DRIFT_SAMPLES) count = MAX_DRIFT_SAMPLES;
+    preferences.putBytes("driftSmp", samples, count * sizeof(DriftSample));
+    preferences.putUChar("driftCnt", count);
+    return true;
+}
+
+uint32_t ConfigService::getRtcSetTime() {
+    return rtcSetTime;
+}
+
+void ConfigService::setRtcSetTime(uint32_t utcTime) {
+    rtcSetTime = utcTime;
+    preferences.putUInt("rtcSetAt", utcTime);
+}
+
+int8_t ConfigService::getAgingOffset() {
+    return agingOffset;
+}
+
+int32_t ConfigService::getDriftResidualPpb() {
+    return driftResidualPpb;
+}
+
+void ConfigService::setDriftCompensation(int8_t aging, int32_t residualPpb) {
+    agingOffset = aging;
+    driftResidualPpb = residualPpb;
+    preferences.putChar("agingOff", aging);
+    preferences.putInt("driftPpb", residualPpb);
+    Serial.printf("[CONFIG] Drift compensation updated: aging %d, residual %ld ppb\n",
+                  aging, (long)residualPpb);
+}
+
+uint8_t ConfigService::getServoCloseAngle() {
+    return servoCloseAngle;
+}
+
+uint8_t ConfigService::getServoOpenAngle() {
+    return servoOpenAngle;
+}
+
+bool ConfigService::setServoAngles(uint8_t closeAngle, uint8_t openAngle) {
+    if (openAngle > 180 || openAngle < closeAngle + MIN_SERVO_TRAVEL_DEG) return false;
+    if (closeAngle != servoCloseAngle || openAngle != servoOpenAngle) {
+        servoCloseAngle = closeAngle;
+        servoOpenAngle = openAngle;
+        markDirty(DIRTY_SERVO_ANGLES);
+    }
+    Serial.printf("[CONFIG] Servo angles updated: close %d, open %d\n", closeAngle, openAngle);
+    return true;
+}
+
+uint16_t ConfigService::getOpenDwellMs() {
+    return openDwellMs;
+}
+
+void ConfigService::setOpenDwellMs(uint16_t ms) {
+    if (ms != openDwellMs) {
+        openDwellMs = ms;
+        markDirty(DIRTY_OPEN_DWELL);
+    }
+    Serial.printf("[CONFIG] Open dwell updated to %dms\n", ms);
+}
+
+uint16_t ConfigService::getPortionGapMs() {
+    return portionGapMs;
+}
+
+void ConfigService::setPortionGapMs(uint16_t ms) {
+    if (ms != portionGapMs) {
+        portionGapMs = ms;
+        markDirty(DIRTY_PORTION_GAP);
+    }
+    Serial.printf("[CONFIG] Portion gap updated to %dms\n", ms);
+}
+
+uint8_t ConfigService::getBarrierPulsesPerPortion() {
+    return barrierPulsesPerPortion;
+}
+
+void ConfigService::setBarrierPulsesPerPortion(uint8_t pulses) {
+    if (pulses != barrierPulsesPerPortion) {
+        barrierPulsesPerPortion = pulses;
+        markDirty(DIRTY_BARRIER_PULSES);
+    }
+    Serial.printf("[CONFIG] Light barrier pulses per portion updated to %d\n", pulses);
+}
+
 bool ConfigService::isVibrationEnabled() {
     return vibrationEnabled;
 }
 
 void ConfigService::setVibrationEnabled(bool enabled) {
-    vibrationEnabled = enabled;
-    preferences.putBool("vibEnabled", enabled);
+    if (enabled != vibrationEnabled) {
+        vibrationEnabled = enabled;
+        markDirty(DIRTY_VIBRATION_ENABLED);
+    }
     Serial.printf("[CONFIG] Vibration enabled updated to %d\n", enabled);
 }
 
@@ -162,11 +550,58 @@ uint8_t ConfigService::getVibrationPulseSeconds() {
 }
 
 void ConfigService::setVibrationPulseSeconds(uint8_t seconds) {
-    vibrationPulseSeconds = seconds;
-    preferences.putUChar("vibPulseSec", seconds);
+    if (seconds != vibrationPulseSeconds) {
+        vibrationPulseSeconds = seconds;
+        markDirty(DIRTY_VIBRATION_PULSE);
+    }
     Serial.printf("[CONFIG] Vibration pulse duration updated to %ds\n", seconds);
 }
 
+uint8_t ConfigService::getVibrationPattern() {
+    return vibrationPattern;
+}
+
+void ConfigService::setVibrationPattern(uint8_t pattern) {
+    if (pattern != vibrationPattern) {
+        vibrationPattern = pattern;
+        markDirty(DIRTY_VIBRATION_PATTERN);
+    }
+    Serial.printf("[CONFIG] Vibration pattern updated to %d\n", pattern);
+}
+
+uint16_t ConfigService::getPreAgitationMs() {
+    return preAgitationMs;
+}
+
+void ConfigService::setPreAgitationMs(uint16_t ms) {
+    if (ms != preAgitationMs) {
+        preAgitationMs = ms;
+        markDirty(DIRTY_PRE_AGITATION);
+    }
+    Serial.printf("[CONFIG] Pre-agitation updated to %dms\n", ms);
+}
+
+bool ConfigService::saveFeedMetrics(const FeedMetrics &metrics) {
+    size_t written = preferences.putBytes("feedMetrics", &metrics, sizeof(FeedMetrics));
+    Serial.printf("[CONFIG] Saved feed timing metrics (%d bytes)\n", written);
+    return written == sizeof(FeedMetrics);
+}
+
+bool ConfigService::loadFeedMetrics(FeedMetrics &metrics) {
+    // A layout change (more buckets or states) shows up as a size mismatch
+    if (preferences.getBytesLength("feedMetrics") != sizeof(FeedMetrics)) {
+        return false;
+    }
+    return preferences.getBytes("feedMetrics", &metrics, sizeof(FeedMetrics)) == sizeof(FeedMetrics);
+}
+
+// Blob layout of the NVS history before it was packed: 8-byte slots in
+// ring order, counting portion units
+struct LegacyFeedHistoryEntry {
+    uint32_t timestamp;
+    uint8_t portion_units;
+};
+
 bool ConfigService::saveFeedHistory(const FeedHistoryEntry* history, uint8_t count, uint8_t writeIndex) {
     if (count > MAX_FEED_HISTORY) {
         count = MAX_FEED_HISTORY;
@@ -175,20 +610,40 @@ bool ConfigService::saveFeedHistory(const FeedHistoryEntry* history, uint8_t cou
         writeIndex = count % MAX_FEED_HISTORY;
     }
 
-    // Save history as binary blob for efficiency
-    size_t dataSize = count * sizeof(FeedHistoryEntry);
-    preferences.putBytes("feedHist", history, dataSize);
-    preferences.putUChar("feedHistCnt", count);
-    preferences.putUChar("feedHistIdx", writeIndex);
+    // The packed block runs oldest first; a full ring starts at the write index
+    FeedHistoryEntry ordered[MAX_FEED_HISTORY];
+    uint8_t first = count < MAX_FEED_HISTORY ? 0 : writeIndex;
+    for (uint8_t i = 0; i < count; i++) {
+        ordered[i] = history[(first + i) % MAX_FEED_HISTORY];
+    }
+
+    // Encoded now, written with the next flush
+    pendingHistorySize = FeedRecord::encodeBlock(ordered, count, pendingHistory, sizeof(pendingHistory));
+    markDirty(DIRTY_FEED_HISTORY);
 
-    Serial.printf("[CONFIG] Saved %d feed history entries (%d bytes), write index %d\n", count, dataSize, writeIndex);
+    Serial.printf("[CONFIG] Feed history updated: %d entries (%d bytes)\n", count, pendingHistorySize);
     return true;
 }
 
 uint8_t ConfigService::loadFeedHistory(FeedHistoryEntry* history, uint8_t maxCount, uint8_t &writeIndex) {
-    uint8_t count = preferences.getUChar("feedHistCnt", 0);
     writeIndex = 0;
 
+    if (dirty & DIRTY_FEED_HISTORY) {
+        uint8_t count = FeedRecord::decodeBlock(pendingHistory, pendingHistorySize, history, maxCount);
+        writeIndex = count % MAX_FEED_HISTORY;
+        return count;
+    }
+
+    if (preferences.isKey("feedPack")) {
+        uint8_t blob[FEED_HISTORY_BLOB_SIZE];
+        size_t size = preferences.getBytes("feedPack", blob, sizeof(blob));
+        uint8_t count = FeedRecord::decodeBlock(blob, size, history, maxCount);
+        writeIndex = count % MAX_FEED_HISTORY;
+        Serial.printf("[CONFIG] Loaded %d feed history entries\n", count);
+        return count;
+    }
+
+    uint8_t count = preferences.getUChar("feedHistCnt", 0);
     if (count == 0) {
         Serial.println("[CONFIG] No feed history found");
         return 0;
@@ -198,24 +653,37 @@ uint8_t ConfigService::loadFeedHistory(FeedHistoryEntry* history, uint8_t maxCou
         count = maxCount;
     }
 
-    size_t expectedSize = count * sizeof(FeedHistoryEntry);
-    size_t actualSize = preferences.getBytes("feedHist", history, expectedSize);
+    // Saved before the packed format: units become grams at the current
+    // portion size, the closest there is to what was fed
+    LegacyFeedHistoryEntry legacy[MAX_FEED_HISTORY];
+    size_t expectedSize = count * sizeof(LegacyFeedHistoryEntry);
+    size_t actualSize = preferences.getBytes("feedHist", legacy, expectedSize);
 
     if (actualSize != expectedSize) {
         Serial.printf("[CONFIG] Feed history size mismatch: expected %d, got %d\n", expectedSize, actualSize);
         return 0;
     }
 
+    for (uint8_t i = 0; i < count; i++) {
+        history[i].timestamp = legacy[i].timestamp;
+        history[i].grams = legacy[i].portion_units * portionUnitGrams;
+        history[i].tag = FEED_TAG_UNKNOWN;
+    }
+
     writeIndex = preferences.getUChar("feedHistIdx", count % MAX_FEED_HISTORY);
     if (writeIndex >= MAX_FEED_HISTORY) {
         writeIndex = count % MAX_FEED_HISTORY;
     }
 
-    Serial.printf("[CONFIG] Loaded %d feed history entries, write index %d\n", count, writeIndex);
+    Serial.printf("[CONFIG] Loaded %d legacy feed history entries, write index %d\n", count, writeIndex);
     return count;
 }
 
 bool ConfigService::clearFeedHistory() {
+    portENTER_CRITICAL(&dirtyMux);
+    dirty &= ~DIRTY_FEED_HISTORY;
+    portEXIT_CRITICAL(&dirtyMux);
+    preferences.remove("feedPack");
     preferences.remove("feedHist");
     preferences.remove("feedHistCnt");
     preferences.remove("feedHistIdx");
@@ -239,8 +707,16 @@ bool ConfigService::resetToDefaults() {
     saveAllSchedules(defaults);
     setPortionUnitGrams(12);
     setManualPortionUnits(1);
+    setBatchWindowMinutes(0);
+    setTimeZone(DEFAULT_TIME_ZONE);
+    setServoAngles(DEFAULT_SERVO_CLOSE_ANGLE, DEFAULT_SERVO_OPEN_ANGLE);
+    setOpenDwellMs(DEFAULT_OPEN_DWELL_MS);
+    setPortionGapMs(DEFAULT_PORTION_GAP_MS);
+    setBarrierPulsesPerPortion(0);
     setVibrationEnabled(true);
     setVibrationPulseSeconds(3);
+    setVibrationPattern(0);
+    setPreAgitationMs(DEFAULT_PRE_AGITATION_MS);
     clearFeedHistory();
 
     Serial.println("[CONFIG] Reset complete");
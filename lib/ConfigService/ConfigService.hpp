@@ -4,12 +4,38 @@
 #include <Arduino.h>
 #include <Preferences.h>
 #include <ArduinoJson.h>
+#include "TimeZone.hpp"
+#include "FeedRecord.hpp"
 
 // Forward declaration - actual definition in FeedingService.hpp
-struct FeedHistoryEntry;
+struct FeedMetrics;
 
 #define MAX_SCHEDULES 6
-#define MAX_FEED_HISTORY 10
+#define MAX_BATCH_WINDOW_MINUTES 30
+#define MAX_DRIFT_SAMPLES 8
+
+// Settings and the NVS feed history are written behind: flush() once no
+// feed has run and nothing changed for the settle time, or at the latest
+// this long after the first unsaved change
+#define CONFIG_FLUSH_SETTLE_MS 2000
+#define CONFIG_FLUSH_DEADLINE_MS 30000
+
+// Packed history block: base timestamp plus the largest record per entry
+#define FEED_HISTORY_BLOB_SIZE (sizeof(uint32_t) + MAX_FEED_HISTORY * FEED_RECORD_MAX_SIZE)
+
+// Servo endpoint and dwell limits (see FeedingService)
+#define DEFAULT_SERVO_CLOSE_ANGLE 0
+#define DEFAULT_SERVO_OPEN_ANGLE 180
+#define MIN_SERVO_TRAVEL_DEG 20
+#define DEFAULT_OPEN_DWELL_MS 1000
+#define DEFAULT_PORTION_GAP_MS 250
+#define MIN_OPEN_DWELL_MS 100
+#define MAX_DWELL_MS 5000
+#define MAX_BARRIER_PULSES_PER_PORTION 200
+
+// Vibration before the first opening (see FeedingService)
+#define DEFAULT_PRE_AGITATION_MS 500
+#define MAX_PRE_AGITATION_MS 3000
 
 struct Schedule {
     uint8_t id;
@@ -19,35 +45,117 @@ struct Schedule {
     uint8_t portion_units; // 1-10 units
 };
 
+// "HH:MM" <-> minute of the day (0-1439); parse fails on anything else
+bool parseScheduleTime(const char *time, uint16_t &minuteOfDay);
+void formatScheduleTime(uint16_t minuteOfDay, char time[6]);
+
+// One RTC-vs-true-time comparison taken at a time sync (see ClockService)
+struct DriftSample {
+    uint32_t syncTime;    // UTC of the sync that measured it
+    uint32_t interval;    // Seconds since the RTC was last set
+    int32_t errorMs;      // Raw RTC minus true time
+    int8_t agingOffset;   // DS3231 aging register during the interval
+};
+
 class ConfigService {
 public:
     ConfigService();
 
     bool begin();
 
-    // Schedule management
+    // Write-behind: the setters below (schedules, time zone and clock
+    // state excepted) and saveFeedHistory() only update RAM and mark their
+    // key. update() flushes from loop() when idle is true, i.e. no feed is
+    // running that the flash work could delay; flush() writes everything
+    // pending now, before deep sleep or a restart.
+    void update(bool idle);
+    bool flush();
+    bool isDirty() const { return dirty != 0; }
+
+    // Schedule management. All schedules are one binary blob, read once
+    // by begin(); loads copy from RAM, a save is a single write. A blob
+    // that can't be used loads as defaults, returning false until the
+    // next save. Saving fails on a time that isn't a valid "HH:MM".
     bool loadSchedule(uint8_t index, Schedule &schedule);
     bool saveSchedule(uint8_t index, const Schedule &schedule);
     bool loadAllSchedules(Schedule schedules[MAX_SCHEDULES]);
     bool saveAllSchedules(const Schedule schedules[MAX_SCHEDULES]);
 
+    // Bumped on every schedule save; lets consumers that cached compiled
+    // schedules (e.g. across deep sleep) tell whether they are stale
+    uint32_t getScheduleGeneration() const { return scheduleGeneration; }
+
+    // Bumped on every change to a setting or schedule, in RAM only:
+    // unchanged means nothing needs redoing. RTC and drift state don't
+    // count, nothing renders or compiles them. Starts at a random value on
+    // each boot, so a number seen before a reboot doesn't match after it.
+    uint32_t getGeneration() const { return generation; }
+
     // Config metadata
     uint8_t getPortionUnitGrams();
     void setPortionUnitGrams(uint8_t grams);
     uint8_t getManualPortionUnits();
     void setManualPortionUnits(uint8_t units);
 
+    // Scheduled feeds closer together than this are dispensed in one wake
+    uint8_t getBatchWindowMinutes();
+    void setBatchWindowMinutes(uint8_t minutes);
+
+    // POSIX TZ rule for local time (validated by the caller). Schedules
+    // are compiled against it, so a change counts as a schedule change.
+    const char* getTimeZone();
+    void setTimeZone(const char *posix);
+
+    // Whether the DS3231 has been switched from local time to UTC
+    bool isRtcUtc();
+    void setRtcUtc(bool utc);
+
+    // RTC drift learning: sample history (oldest first), the UTC time the
+    // RTC was last set, and the fitted aging offset / residual rate
+    uint8_t loadDriftSamples(DriftSample* samples, uint8_t maxCount);
+    bool saveDriftSamples(const DriftSample* samples, uint8_t count);
+    uint32_t getRtcSetTime();
+    void setRtcSetTime(uint32_t utcTime);
+    int8_t getAgingOffset();
+    int32_t getDriftResidualPpb();
+    void setDriftCompensation(int8_t agingOffset, int32_t residualPpb);
+
+    // Servo endpoints (0-180°, open at least MIN_SERVO_TRAVEL_DEG past
+    // close) and how long the gate stays open / closed between portions
+    uint8_t getServoCloseAngle();
+    uint8_t getServoOpenAngle();
+    bool setServoAngles(uint8_t closeAngle, uint8_t openAngle);
+    uint16_t getOpenDwellMs();
+    void setOpenDwellMs(uint16_t ms);
+    uint16_t getPortionGapMs();
+    void setPortionGapMs(uint16_t ms);
+
+    // Light barrier pulses a full portion unit produces; 0 only counts,
+    // without verifying portions or closing early
+    uint8_t getBarrierPulsesPerPortion();
+    void setBarrierPulsesPerPortion(uint8_t pulses);
+
     // Vibration motor config
     bool isVibrationEnabled();
     void setVibrationEnabled(bool enabled);
     uint8_t getVibrationPulseSeconds();
     void setVibrationPulseSeconds(uint8_t seconds);
+    // VibrationPattern used for feeds, and how long the motor runs before
+    // the first opening (servo power-up overlaps with it)
+    uint8_t getVibrationPattern();
+    void setVibrationPattern(uint8_t pattern);
+    uint16_t getPreAgitationMs();
+    void setPreAgitationMs(uint16_t ms);
 
     // Feed history management
     bool saveFeedHistory(const FeedHistoryEntry* history, uint8_t count, uint8_t writeIndex);
     uint8_t loadFeedHistory(FeedHistoryEntry* history, uint8_t maxCount, uint8_t &writeIndex);
     bool clearFeedHistory();
 
+    // Feed timing histograms (see FeedingService), saved before deep sleep
+    bool saveFeedMetrics(const FeedMetrics &metrics);
+    bool loadFeedMetrics(FeedMetrics &metrics);
+
     // Reset to defaults
     bool resetToDefaults();
 
@@ -55,10 +163,44 @@ private:
     Preferences preferences;
     uint8_t portionUnitGrams;
     uint8_t manualPortionUnits;
+    uint8_t batchWindowMinutes;
+    char timeZone[TIME_ZONE_MAX_LEN + 1];
+    uint8_t servoCloseAngle;
+    uint8_t servoOpenAngle;
+    uint16_t openDwellMs;
+    uint16_t portionGapMs;
+    uint8_t barrierPulsesPerPortion;
     bool vibrationEnabled;
     uint8_t vibrationPulseSeconds;
+    uint8_t vibrationPattern;
+    uint16_t preAgitationMs;
+    uint32_t scheduleGeneration;
+    bool rtcUtc;
+    uint32_t rtcSetTime;
+    int8_t agingOffset;
+    int32_t driftResidualPpb;
+
+    Schedule schedules[MAX_SCHEDULES];
+    bool schedulesValid;
+    uint32_t generation;
+
+    // Unsaved keys (DIRTY_* bits) and when they changed. Setters run on
+    // the web server's task too, so these and generation are only touched
+    // under dirtyMux. A setter assigns its field before marking it, so a
+    // flush that takes the bit also sees the new value.
+    uint16_t dirty;
+    unsigned long firstDirtyMs;
+    unsigned long lastChangeMs;
+    portMUX_TYPE dirtyMux = portMUX_INITIALIZER_UNLOCKED;
+    uint8_t pendingHistory[FEED_HISTORY_BLOB_SIZE];
+    size_t pendingHistorySize;
 
     void getScheduleKey(uint8_t index, char *key);
+    bool readSchedules(Schedule out[MAX_SCHEDULES]);
+    bool loadLegacySchedule(uint8_t index, Schedule &schedule);
+    void migrateSchedules();
+    void markDirty(uint16_t bits);
+    void bumpGeneration();
 };
 
 #endif // CONFIG_SERVICE_HPP
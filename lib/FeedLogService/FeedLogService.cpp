@@ -0,0 +1,273 @@
+#include "FeedLogService.hpp"
+
+// Flash is read in chunks of this much while walking a sector
+static const size_t READ_CHUNK = 256;
+
+// Holds the log's mutex for a scope, so a read never walks a sector that
+// is being erased or an order[] that is being re-sorted
+class FeedLogLock {
+public:
+    explicit FeedLogLock(SemaphoreHandle_t mutex) : mutex(mutex) { xSemaphoreTake(mutex, portMAX_DELAY); }
+    ~FeedLogLock() { xSemaphoreGive(mutex); }
+
+private:
+    SemaphoreHandle_t mutex;
+};
+
+FeedLogService::FeedLogService()
+    : mutex(nullptr), partition(nullptr), sectorCount(0), usedSectors(0) {
+    memset(sectors, 0, sizeof(sectors));
+}
+
+template <typename Visit>
+size_t FeedLogService::forEachRecord(uint8_t sector, Visit visit) const {
+    const FeedLogSectorIndex &index = sectors[sector];
+    uint8_t buffer[READ_CHUNK];
+    size_t bufferStart = 0;
+    size_t bufferEnd = 0;
+    size_t pos = sizeof(FeedLogSectorHeader);
+    uint32_t previous = index.base;
+
+    while (pos < index.used) {
+        // Keep a whole record in the buffer
+        if (pos + FEED_RECORD_MAX_SIZE > bufferEnd && bufferEnd < FEED_LOG_SECTOR_SIZE) {
+            bufferStart = pos;
+            bufferEnd = pos + READ_CHUNK < FEED_LOG_SECTOR_SIZE ? pos + READ_CHUNK : FEED_LOG_SECTOR_SIZE;
+            if (esp_partition_read(partition, sectorOffset(sector) + pos, buffer, bufferEnd - bufferStart) != ESP_OK) {
+                return FEED_LOG_SECTOR_SIZE;
+            }
+        }
+        const uint8_t *data = &buffer[pos - bufferStart];
+
+        if (data[0] == 0xFF) return pos;
+        // A header byte torn on its own, or a record running past the
+        // sector: nothing after it can be trusted to be erased
+        uint8_t len = FeedRecord::length(data[0]);
+        if (len == 0 || pos + len > FEED_LOG_SECTOR_SIZE) return FEED_LOG_SECTOR_SIZE;
+        pos += len;
+
+        FeedHistoryEntry entry;
+        if (!FeedRecord::decode(data, previous, entry)) continue;
+        previous = entry.timestamp;
+
+        if (!visit(entry)) return pos;
+    }
+    return pos;
+}
+
+bool FeedLogService::begin() {
+    // Once: begin() may run again to re-index the partition
+    if (!mutex) mutex = xSemaphoreCreateMutex();
+    FeedLogLock lock(mutex);
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                         (esp_partition_subtype_t)FEED_LOG_PARTITION_SUBTYPE,
+                                         FEED_LOG_PARTITION_LABEL);
+    if (!partition) {
+        Serial.println("[FEEDLOG] No feedlog partition - feed history stays in NVS");
+        return false;
+    }
+
+    uint32_t count = partition->size / FEED_LOG_SECTOR_SIZE;
+    if (count < 2) {
+        // Rotation needs a sector to erase while another still holds records
+        Serial.println("[FEEDLOG] feedlog partition too small");
+        partition = nullptr;
+        return false;
+    }
+    sectorCount = count > FEED_LOG_MAX_SECTORS ? FEED_LOG_MAX_SECTORS : count;
+
+    for (uint8_t i = 0; i < sectorCount; i++) {
+        indexSector(i);
+    }
+    sortSectors();
+    // Only the newest sector is walked; the others are full
+    if (usedSectors > 0) findEnd(order[0]);
+
+    Serial.printf("[FEEDLOG] %lu of %lu bytes used in %d sectors\n",
+                  (unsigned long)getUsedBytes(), (unsigned long)getCapacityBytes(), usedSectors);
+    return true;
+}
+
+void FeedLogService::indexSector(uint8_t sector) {
+    FeedLogSectorIndex &index = sectors[sector];
+    memset(&index, 0, sizeof(index));
+
+    FeedLogSectorHeader header;
+    if (esp_partition_read(partition, sectorOffset(sector), &header, sizeof(header)) != ESP_OK ||
+        header.magic != FEED_LOG_MAGIC || header.sequence == 0) {
+        // Erased, or the header write was torn: reused on the next rotation
+        return;
+    }
+
+    index.sequence = header.sequence;
+    index.base = header.timestamp;
+    index.used = FEED_LOG_SECTOR_SIZE;
+    index.firstDay = header.timestamp / SECONDS_PER_DAY;
+}
+
+void FeedLogService::sortSectors() {
+    usedSectors = 0;
+    for (uint8_t i = 0; i < sectorCount; i++) {
+        if (sectors[i].sequence == 0) continue;
+
+        uint8_t pos = usedSectors++;
+        while (pos > 0 && sectors[order[pos - 1]].sequence < sectors[i].sequence) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+}
+
+void FeedLogService::findEnd(uint8_t sector) {
+    FeedLogSectorIndex &index = sectors[sector];
+    uint32_t last = index.base;
+    index.used = FEED_LOG_SECTOR_SIZE;
+    index.used = forEachRecord(sector, [&last](const FeedHistoryEntry &entry) {
+        last = entry.timestamp;
+        return true;
+    });
+    index.last = last;
+}
+
+uint16_t FeedLogService::lastDay(uint8_t position) const {
+    // Records are in time order, so a sector ends no later than the day
+    // the next one starts
+    if (position == 0) return sectors[order[0]].last / SECONDS_PER_DAY;
+    return sectors[order[position - 1]].firstDay;
+}
+
+bool FeedLogService::startSector(uint8_t sector, uint32_t sequence, uint32_t timestamp) {
+    memset(&sectors[sector], 0, sizeof(FeedLogSectorIndex));
+
+    size_t offset = sectorOffset(sector);
+    if (esp_partition_erase_range(partition, offset, FEED_LOG_SECTOR_SIZE) != ESP_OK) {
+        Serial.printf("[FEEDLOG] Erasing sector %d failed\n", sector);
+        sortSectors();
+        return false;
+    }
+
+    FeedLogSectorHeader header = {FEED_LOG_MAGIC, sequence, timestamp};
+    if (esp_partition_write(partition, offset, &header, sizeof(header)) != ESP_OK) {
+        Serial.printf("[FEEDLOG] Writing sector %d header failed\n", sector);
+        sortSectors();
+        return false;
+    }
+
+    FeedLogSectorIndex &index = sectors[sector];
+    index.sequence = sequence;
+    index.base = timestamp;
+    index.used = sizeof(header);
+    index.firstDay = timestamp / SECONDS_PER_DAY;
+    index.last = timestamp;
+    sortSectors();
+    return true;
+}
+
+bool FeedLogService::append(const FeedHistoryEntry &entry) {
+    if (!partition) return false;
+    FeedLogLock lock(mutex);
+
+    uint8_t record[FEED_RECORD_MAX_SIZE];
+    uint8_t len = 0;
+    bool rotate = usedSectors == 0;
+    if (!rotate) {
+        const FeedLogSectorIndex &head = sectors[order[0]];
+        len = FeedRecord::encode(entry, head.last, record);
+        rotate = head.used + len > FEED_LOG_SECTOR_SIZE;
+    }
+    if (rotate) {
+        // Sectors go round in turn, so the one after the newest is the oldest
+        uint8_t next = usedSectors == 0 ? 0 : (order[0] + 1) % sectorCount;
+        uint32_t sequence = usedSectors == 0 ? 1 : sectors[order[0]].sequence + 1;
+        if (!startSector(next, sequence, entry.timestamp)) return false;
+        len = FeedRecord::encode(entry, entry.timestamp, record);
+    }
+
+    FeedLogSectorIndex &index = sectors[order[0]];
+
+    // A failed write may still have programmed part of the record - never
+    // reuse it. The next record stays relative to the last good one, the
+    // same as a reader that skips this one.
+    size_t offset = sectorOffset(order[0]) + index.used;
+    index.used += len;
+    if (esp_partition_write(partition, offset, record, len) != ESP_OK) {
+        Serial.printf("[FEEDLOG] Writing record at 0x%x failed\n", offset);
+        return false;
+    }
+    index.last = entry.timestamp;
+    return true;
+}
+
+uint16_t FeedLogService::readRecent(FeedHistoryEntry *out, uint16_t maxCount, uint16_t skip) const {
+    if (!partition) return 0;
+    FeedLogLock lock(mutex);
+
+    uint16_t count = 0;
+    for (uint8_t i = 0; i < usedSectors && count < maxCount; i++) {
+        uint8_t sector = order[i];
+        uint16_t valid = 0;
+        forEachRecord(sector, [&valid](const FeedHistoryEntry &) {
+            valid++;
+            return true;
+        });
+        if (skip >= valid) {
+            skip -= valid;
+            continue;
+        }
+
+        // Records can only be walked oldest first: copy the newest `take`
+        // below the skipped ones into place back to front
+        uint16_t end = valid - skip;
+        uint16_t take = end < maxCount - count ? end : maxCount - count;
+        uint16_t first = end - take;
+        uint16_t n = 0;
+        FeedHistoryEntry *dest = &out[count];
+        forEachRecord(sector, [&](const FeedHistoryEntry &entry) {
+            if (n >= first) dest[end - 1 - n] = entry;
+            return ++n < end;
+        });
+        count += take;
+        skip = 0;
+    }
+    return count;
+}
+
+uint32_t FeedLogService::sumGrams(uint32_t fromUtc, uint32_t toUtc) const {
+    if (!partition || toUtc <= fromUtc) return 0;
+    FeedLogLock lock(mutex);
+
+    uint16_t fromDay = fromUtc / SECONDS_PER_DAY;
+    uint16_t toDay = (toUtc - 1) / SECONDS_PER_DAY;
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < usedSectors; i++) {
+        // The day index skips every sector without a record in the range
+        if (sectors[order[i]].firstDay > toDay || lastDay(i) < fromDay) continue;
+
+        forEachRecord(order[i], [&](const FeedHistoryEntry &entry) {
+            if (entry.timestamp >= fromUtc && entry.timestamp < toUtc) {
+                total += entry.grams;
+            }
+            return true;
+        });
+    }
+    return total;
+}
+
+uint32_t FeedLogService::getUsedBytes() const {
+    if (usedSectors == 0) return 0;
+    return (uint32_t)(usedSectors - 1) * FEED_LOG_SECTOR_SIZE + sectors[order[0]].used;
+}
+
+bool FeedLogService::clear() {
+    if (!partition) return false;
+    FeedLogLock lock(mutex);
+
+    bool ok = esp_partition_erase_range(partition, 0, (size_t)sectorCount * FEED_LOG_SECTOR_SIZE) == ESP_OK;
+    memset(sectors, 0, sizeof(sectors));
+    usedSectors = 0;
+    Serial.println("[FEEDLOG] Feed log cleared");
+    return ok;
+}
+
@@ -0,0 +1,89 @@
+#ifndef FEED_LOG_SERVICE_HPP
+#define FEED_LOG_SERVICE_HPP
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "FeedRecord.hpp"
+
+// Raw data partition from partitions.csv
+#define FEED_LOG_PARTITION_LABEL "feedlog"
+#define FEED_LOG_PARTITION_SUBTYPE 0x40
+#define FEED_LOG_SECTOR_SIZE 4096
+#define FEED_LOG_MAX_SECTORS 32  // RAM index size; a larger partition uses only this much
+#define FEED_LOG_MAGIC 0x324F4C46  // "FLO2"
+
+#define SECONDS_PER_DAY 86400UL
+
+// On flash: a header at the start of every sector, then packed records
+// (FeedRecord.hpp) back to back, the first relative to the header's base.
+// Erased flash reads 0xFF and no record starts with it, so the first
+// 0xFF header byte is where the next record goes.
+struct FeedLogSectorHeader {
+    uint32_t magic;
+    uint32_t sequence;   // Counts up with every sector started; the oldest has the lowest
+    uint32_t timestamp;  // Of the sector's first record
+};
+
+// What begin() learns about a sector, so reads can skip sectors by day
+struct FeedLogSectorIndex {
+    uint32_t sequence;  // 0: erased or not a log sector
+    uint32_t base;      // Header timestamp
+    uint16_t used;      // Bytes written, torn records included (newest sector only)
+    uint16_t firstDay;  // UTC day (unix time / 86400) of the first valid record
+    uint32_t last;      // Newest record's timestamp (newest sector only)
+};
+
+// Append-only feed log in its own flash partition. Sectors are used in
+// turn; when the newest is full the oldest is erased and reused, so every
+// sector sees the same number of erase cycles. One feed costs one
+// 4-10 byte program (typically 5) and, every ~800 feeds, a sector erase.
+class FeedLogService {
+public:
+    FeedLogService();
+
+    // Find and index the partition; false if the flashed partition table
+    // has none (the caller then keeps history in NVS)
+    bool begin();
+    bool isAvailable() const { return partition != nullptr; }
+
+    bool append(const FeedHistoryEntry &entry);
+
+    // Newest first, after skipping `skip` records; returns the number copied
+    uint16_t readRecent(FeedHistoryEntry *out, uint16_t maxCount, uint16_t skip = 0) const;
+    // Grams fed from fromUtc (inclusive) to toUtc (exclusive)
+    uint32_t sumGrams(uint32_t fromUtc, uint32_t toUtc) const;
+
+    bool isEmpty() const { return usedSectors == 0; }
+    // Approximate fill: whole sectors before the newest, plus what it holds
+    uint32_t getUsedBytes() const;
+    uint32_t getCapacityBytes() const { return (uint32_t)sectorCount * FEED_LOG_SECTOR_SIZE; }
+
+    bool clear();
+
+private:
+    // Reads come from the web server's task, appends from the loop task:
+    // every public method that touches flash or the index holds this
+    SemaphoreHandle_t mutex;
+    const esp_partition_t *partition;
+    uint8_t sectorCount;
+    FeedLogSectorIndex sectors[FEED_LOG_MAX_SECTORS];
+    uint8_t order[FEED_LOG_MAX_SECTORS];  // Sector numbers, newest first
+    uint8_t usedSectors;                  // Entries in order[]
+
+    void indexSector(uint8_t sector);
+    void sortSectors();
+    void findEnd(uint8_t sector);
+    bool startSector(uint8_t sector, uint32_t sequence, uint32_t timestamp);
+    uint16_t lastDay(uint8_t position) const;
+
+    // Calls visit(entry) for every valid record of a sector, oldest first,
+    // until it returns false. Returns where it stopped: the first erased
+    // byte, or the sector size if what follows can't be trusted.
+    template <typename Visit>
+    size_t forEachRecord(uint8_t sector, Visit visit) const;
+    static size_t sectorOffset(uint8_t sector) { return (size_t)sector * FEED_LOG_SECTOR_SIZE; }
+};
+
+#endif // FEED_LOG_SERVICE_HPP
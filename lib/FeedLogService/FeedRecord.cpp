@@ -0,0 +1,107 @@
+#include "FeedRecord.hpp"
+#include <esp_rom_crc.h>
+
+namespace FeedRecord {
+
+static uint8_t putVarint(uint32_t value, uint8_t *out) {
+    uint8_t len = 0;
+    while (value >= 0x80) {
+        out[len++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[len++] = value;
+    return len;
+}
+
+static uint8_t getVarint(const uint8_t *data, uint8_t avail, uint32_t &value) {
+    value = 0;
+    for (uint8_t i = 0; i < avail && i < 5; i++) {
+        value |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) return i + 1;
+    }
+    return 0;
+}
+
+static uint8_t check(const uint8_t *data, uint8_t len) {
+    return esp_rom_crc8_le(0, data, len) & 0x7F;
+}
+
+uint8_t encode(const FeedHistoryEntry &entry, uint32_t previousTimestamp, uint8_t *out) {
+    // Zigzag, so a clock set back between two feeds is a small number too
+    int32_t delta = (int32_t)(entry.timestamp - previousTimestamp);
+    uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+
+    uint8_t len = 1;
+    len += putVarint(zigzag, &out[len]);
+    len += putVarint(entry.grams, &out[len]);
+    uint8_t tag = entry.tag > FEED_TAG_MAX ? FEED_TAG_UNKNOWN : entry.tag;
+    out[0] = (tag << 3) | (len + 1 - FEED_RECORD_MIN_SIZE);
+    out[len] = check(out, len);
+    return len + 1;
+}
+
+uint8_t length(uint8_t header) {
+    if (header & 0x80) return 0;
+    uint8_t len = (header & 0x07) + FEED_RECORD_MIN_SIZE;
+    return len <= FEED_RECORD_MAX_SIZE ? len : 0;
+}
+
+bool decode(const uint8_t *data, uint32_t previousTimestamp, FeedHistoryEntry &entry) {
+    uint8_t len = length(data[0]);
+    if (len == 0 || data[len - 1] != check(data, len - 1)) return false;
+
+    uint32_t zigzag;
+    uint32_t grams;
+    uint8_t pos = 1;
+    uint8_t used = getVarint(&data[pos], len - 1 - pos, zigzag);
+    if (used == 0) return false;
+    pos += used;
+    used = getVarint(&data[pos], len - 1 - pos, grams);
+    if (used == 0 || pos + used != len - 1 || grams > UINT16_MAX) return false;
+
+    int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+    entry.timestamp = previousTimestamp + delta;
+    entry.grams = grams;
+    entry.tag = (data[0] >> 3) & 0x0F;
+    return true;
+}
+
+size_t encodeBlock(const FeedHistoryEntry *entries, uint16_t count, uint8_t *out, size_t capacity) {
+    if (capacity < sizeof(uint32_t)) return 0;
+
+    uint32_t previous = count > 0 ? entries[0].timestamp : 0;
+    memcpy(out, &previous, sizeof(previous));
+    size_t size = sizeof(previous);
+
+    uint8_t record[FEED_RECORD_MAX_SIZE];
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t len = encode(entries[i], previous, record);
+        if (size + len > capacity) break;
+        memcpy(&out[size], record, len);
+        size += len;
+        previous = entries[i].timestamp;
+    }
+    return size;
+}
+
+uint16_t decodeBlock(const uint8_t *data, size_t size, FeedHistoryEntry *entries, uint16_t maxCount) {
+    if (size < sizeof(uint32_t)) return 0;
+
+    uint32_t previous;
+    memcpy(&previous, data, sizeof(previous));
+    size_t pos = sizeof(previous);
+
+    uint16_t count = 0;
+    while (pos < size && count < maxCount) {
+        uint8_t len = length(data[pos]);
+        if (len == 0 || pos + len > size) break;
+        // Skipping a bad record would put every later one off by its delta
+        if (!decode(&data[pos], previous, entries[count])) break;
+        previous = entries[count].timestamp;
+        count++;
+        pos += len;
+    }
+    return count;
+}
+
+}  // namespace FeedRecord
@@ -0,0 +1,52 @@
+#ifndef FEED_RECORD_HPP
+#define FEED_RECORD_HPP
+
+#include <Arduino.h>
+
+// What triggered a feed: web, button, or a schedule - by id (1-6) when
+// known, FEED_TAG_SCHEDULE when not
+#define FEED_TAG_WEB 0
+#define FEED_TAG_BUTTON 1
+#define FEED_TAG_SCHEDULE 2
+#define FEED_TAG_SCHEDULE_ID(id) (FEED_TAG_SCHEDULE + (id))
+#define FEED_TAG_UNKNOWN 15  // Recorded before feeds were tagged
+#define FEED_TAG_MAX 15
+
+struct FeedHistoryEntry {
+    uint32_t timestamp;  // Unix timestamp (UTC)
+    uint16_t grams;      // Portion size when it was fed, not the current setting
+    uint8_t tag;         // FEED_TAG_*
+};
+
+// Feeds kept in RAM and in the NVS history blob
+#define MAX_FEED_HISTORY 10
+
+// Packed record, each relative to the one before it (or a block's base
+// timestamp for the first):
+//   [header][zigzag varint seconds delta][varint grams][check]
+// header: bit 7 clear, tag in bits 3-6, length - FEED_RECORD_MIN_SIZE in bits 0-2
+// check:  CRC-8 of the bytes before it, bit 7 cleared
+// Neither end of a record can read 0xFF, so erased flash is never taken
+// for a record, and the header alone tells how far a torn one reaches.
+#define FEED_RECORD_MIN_SIZE 4
+#define FEED_RECORD_MAX_SIZE 10
+
+namespace FeedRecord {
+
+// Returns the encoded length
+uint8_t encode(const FeedHistoryEntry &entry, uint32_t previousTimestamp, uint8_t *out);
+
+// Length from the header byte, 0 if it is erased flash (0xFF) or no header
+uint8_t length(uint8_t header);
+
+// Decodes a record of length(data[0]) bytes; false if the check fails
+bool decode(const uint8_t *data, uint32_t previousTimestamp, FeedHistoryEntry &entry);
+
+// A block is a base timestamp followed by records. Return the bytes
+// written / the entries read.
+size_t encodeBlock(const FeedHistoryEntry *entries, uint16_t count, uint8_t *out, size_t capacity);
+uint16_t decodeBlock(const uint8_t *data, size_t size, FeedHistoryEntry *entries, uint16_t maxCount);
+
+}  // namespace FeedRecord
+
+#endif // FEED_RECORD_HPP
@@ -11,35 +11,279 @@ FeedingService::FeedingService() {
 void FeedingService::setup() {
   // Initialize position to closed but don't move yet
   // Movement will happen on first feed() call
-  position = SERVO_MIN_ANGLE;
+  position = configService ? configService->getServoCloseAngle() : SERVO_MIN_ANGLE;
+  closeAngle = position;
   Serial.println("[INFO] FeedingService ready (servos at closed position).");
 }
 
-void FeedingService::feed(uint8_t count) {
+FeedRequestResult FeedingService::feed(uint8_t count, FeedSource source, bool hold, uint8_t scheduleId) {
+  if (count < 1) count = 1;
+  if (count > 10) count = 10;
+
+  if (state == IDLE && queueCount == 0) {
+    currentSource = source;
+    currentScheduleId = scheduleId;
+    startSequence(count, hold, 0);
+    return FEED_STARTED;
+  }
+
+  if (hold) {
+    // Only an idle feeder can be warmed up for an exact start
+    queueStats.dropped++;
+    return FEED_REJECTED;
+  }
+  return enqueue(count, source, scheduleId);
+}
+
+void FeedingService::requestFeed(uint8_t count, FeedSource source) {
+  portENTER_CRITICAL(&requestMux);
+  if (requestedPortions == 0 || source > requestedSource) requestedSource = source;
+  if (count > requestedPortions) requestedPortions = count;
+  portEXIT_CRITICAL(&requestMux);
+}
+
+FeedRequestResult FeedingService::enqueue(uint8_t count, FeedSource source, uint8_t scheduleId) {
+  const unsigned long now = millis();
+
+  // A calibration trial is never the "same" feed
+  if (source != FEED_SOURCE_SCHEDULE && state != IDLE && isFeedSequence && currentSource == source &&
+      !calibration.active) {
+    Serial.printf("[INFO] Feed request from source %d merged with the running feed\n", source);
+    queueStats.merged++;
+    return FEED_MERGED;
+  }
+
+  for (uint8_t i = 0; i < queueCount; i++) {
+    if (queue[i].source != source) continue;
+    if (source == FEED_SOURCE_SCHEDULE) {
+      queue[i].portions = queue[i].portions + count > 10 ? 10 : queue[i].portions + count;
+      if (queue[i].scheduleId != scheduleId) queue[i].scheduleId = 0;
+    } else if (count > queue[i].portions) {
+      queue[i].portions = count;
+    }
+    Serial.printf("[INFO] Feed request from source %d merged into queued feed (%d portions)\n",
+                  source, queue[i].portions);
+    queueStats.merged++;
+    return FEED_MERGED;
+  }
+
+  if (queueCount == FEED_QUEUE_SIZE) {
+    // Sorted by priority, so the last entry is the newest of the lowest
+    if (queue[queueCount - 1].source >= source) {
+      Serial.printf("[WARN] Feed queue full, request from source %d dropped\n", source);
+      queueStats.dropped++;
+      return FEED_REJECTED;
+    }
+    Serial.printf("[WARN] Feed queue full, queued request from source %d displaced\n",
+                  queue[queueCount - 1].source);
+    queueStats.dropped++;
+    queueCount--;
+  }
+
+  // Behind everything of the same or a higher priority
+  uint8_t pos = queueCount;
+  while (pos > 0 && queue[pos - 1].source < source) {
+    queue[pos] = queue[pos - 1];
+    pos--;
+  }
+  queue[pos] = {count, source, now, scheduleId};
+  queueCount++;
+  queueStats.queued++;
+
+  Serial.printf("[INFO] Feed request queued: %d portions from source %d, position %d/%d\n",
+                count, source, pos + 1, queueCount);
+  return FEED_QUEUED;
+}
+
+bool FeedingService::dequeue(FeedRequest &request) {
+  if (queueCount == 0) return false;
+
+  request = queue[0];
+  queueCount--;
+  memmove(&queue[0], &queue[1], queueCount * sizeof(FeedRequest));
+
+  queueStats.lastWaitMs = millis() - request.queuedAt;
+  if (queueStats.lastWaitMs > queueStats.maxWaitMs) queueStats.maxWaitMs = queueStats.lastWaitMs;
+  currentSource = request.source;
+  currentScheduleId = request.scheduleId;
+  return true;
+}
+
+uint32_t FeedingService::getOldestQueuedWaitMs() const {
+  uint32_t oldest = 0;
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < queueCount; i++) {
+    if (now - queue[i].queuedAt > oldest) oldest = now - queue[i].queuedAt;
+  }
+  return oldest;
+}
+
+void FeedingService::startSequence(uint8_t count, bool hold, uint8_t openOverride) {
   if (state != IDLE) {
     Serial.println("[WARN] Feed already in progress, ignoring request.");
     return;
   }
 
-  // Validate count
-  if (count < 1) count = 1;
-  if (count > 10) count = 10;
+  dispenseStats.lastFault = DISPENSE_OK;
+  emptyRun = 0;
+  beginJob(count, openOverride);
+
+  // Loosen the feed before the first opening. The servo power-up runs
+  // during the agitation, so only the part longer than that waits - but
+  // never less than the motor's soft start, so the two inrushes don't add
+  agitationLeadMs = 0;
+  if (vibrationService && (!configService || configService->isVibrationEnabled())) {
+    VibrationPattern pattern = VIBRATION_STEADY;
+    uint16_t preAgitationMs = DEFAULT_PRE_AGITATION_MS;
+    if (configService) {
+      pattern = (VibrationPattern)configService->getVibrationPattern();
+      preAgitationMs = configService->getPreAgitationMs();
+    }
+    vibrationService->startFeedShake(pattern);
+    if (preAgitationMs > SERVO_POWER_UP_TIME) agitationLeadMs = preAgitationMs - SERVO_POWER_UP_TIME;
+    if (agitationLeadMs < VIBRATION_SOFT_START_MS) agitationLeadMs = VIBRATION_SOFT_START_MS;
+  }
 
+  isFeedSequence = true;
+  holdOpen = hold;
+  targetPosition = openAngle;
+  enterState(agitationLeadMs > 0 ? PRE_AGITATE : POWER_ON, millis());
+}
+
+void FeedingService::beginJob(uint8_t count, uint8_t openOverride) {
   feedCount = count;
   feedsCompleted = 0;
+  sequenceStartTime = millis();
+
+  // A config change only applies from the next feed on
+  if (configService) {
+    closeAngle = configService->getServoCloseAngle();
+    openAngle = configService->getServoOpenAngle();
+    openDwellMs = configService->getOpenDwellMs();
+    portionGapMs = configService->getPortionGapMs();
+    pulsesPerPortion = configService->getBarrierPulsesPerPortion();
+  }
+  if (openOverride > 0) openAngle = openOverride;
+  calibrationTrial = openOverride > 0;
 
-  Serial.printf("[INFO] Starting feed sequence: %d portions\n", feedCount);
+  if (hasLightBarrier()) {
+    lightBarrier->arm();
+    portionStartPulses = 0;
+  }
 
-  if (vibrationService && (!configService || configService->isVibrationEnabled())) {
-    vibrationService->startFeedShake();
+  Serial.printf("[INFO] Starting feed sequence: %d portions, %d-%d deg\n", feedCount, closeAngle, openAngle);
+}
+
+bool FeedingService::requestCalibration(CalibrationCommand command) {
+  if (command == CALIBRATION_NONE || pendingCalibration != CALIBRATION_NONE) return false;
+  if (command != CALIBRATION_CANCEL) {
+    // Checked again when update() takes it
+    if (state != IDLE || queueCount > 0) return false;
+    if (command != CALIBRATION_START && !calibration.active) return false;
   }
+  pendingCalibration = command;
+  return true;
+}
 
-  isFeedSequence = true;
-  startMovement(SERVO_MAX_ANGLE, true);
+void FeedingService::runCalibration(CalibrationCommand command) {
+  bool done = true;
+  switch (command) {
+    case CALIBRATION_START:
+      done = startCalibration();
+      break;
+    case CALIBRATION_FULL_UNIT:
+    case CALIBRATION_TOO_LITTLE:
+      done = reportCalibration(command == CALIBRATION_FULL_UNIT);
+      break;
+    case CALIBRATION_CANCEL:
+      cancelCalibration();
+      break;
+    default:
+      break;
+  }
+  if (!done) {
+    Serial.println("[WARN] Calibration request dropped - a feed started first");
+  }
+}
+
+bool FeedingService::startCalibration() {
+  if (state != IDLE || queueCount > 0) return false;
+
+  // Full travel is assumed to dispense a full unit; bisect from there
+  calibration.active = true;
+  calibration.lowAngle = configService ? configService->getServoCloseAngle() : SERVO_MIN_ANGLE;
+  calibration.highAngle = SERVO_MAX_ANGLE;
+  calibration.trials = 0;
+  Serial.printf("[INFO] Servo calibration started between %d and %d deg\n",
+                calibration.lowAngle, calibration.highAngle);
+
+  // Test portions are weighed, not fed; they stay out of the history
+  currentSource = FEED_SOURCE_WEB;
+  currentScheduleId = 0;
+  calibration.testAngle = (calibration.lowAngle + calibration.highAngle) / 2;
+  calibration.trials++;
+  startSequence(1, false, calibration.testAngle);
+  return true;
+}
+
+bool FeedingService::reportCalibration(bool fullUnit) {
+  if (!calibration.active || state != IDLE || queueCount > 0) return false;
+
+  if (fullUnit) {
+    calibration.highAngle = calibration.testAngle;
+  } else {
+    calibration.lowAngle = calibration.testAngle;
+  }
+  Serial.printf("[INFO] Calibration trial %d at %d deg: %s\n", calibration.trials,
+                calibration.testAngle, fullUnit ? "full unit" : "too little");
+
+  uint8_t closed = configService ? configService->getServoCloseAngle() : SERVO_MIN_ANGLE;
+  bool narrow = calibration.highAngle - calibration.lowAngle <= CALIBRATION_RESOLUTION_DEG;
+  bool atMinimum = calibration.highAngle < closed + MIN_SERVO_TRAVEL_DEG;
+  if (narrow || atMinimum) {
+    // The upper end is the smallest opening seen to dispense a full unit
+    calibration.active = false;
+    uint8_t angle = atMinimum ? closed + MIN_SERVO_TRAVEL_DEG : calibration.highAngle;
+    if (configService) {
+      configService->setServoAngles(closed, angle);
+    }
+    Serial.printf("[INFO] Servo calibration done: open angle %d deg after %d trials\n",
+                  angle, calibration.trials);
+    return true;
+  }
+
+  currentSource = FEED_SOURCE_WEB;
+  currentScheduleId = 0;
+  calibration.testAngle = (calibration.lowAngle + calibration.highAngle) / 2;
+  calibration.trials++;
+  startSequence(1, false, calibration.testAngle);
+  return true;
+}
+
+void FeedingService::cancelCalibration() {
+  if (calibration.active) {
+    Serial.println("[INFO] Servo calibration cancelled");
+  }
+  calibration.active = false;
+}
+
+bool FeedingService::isReadyToOpen() const {
+  return holdOpen && state == SERVO_READY && millis() - stateStartTime >= SERVO_ATTACH_DELAY;
+}
+
+void FeedingService::release() {
+  if (!holdOpen) return;
+  holdOpen = false;
+
+  if (state == SERVO_READY) {
+    // The move starts right here, not on the next update()
+    startMoving(millis());
+    Serial.println("[DEBUG] Held feed released");
+  }
 }
 
 bool FeedingService::isFeeding() {
-  return (state != IDLE) || isFeedSequence;
+  return (state != IDLE) || isFeedSequence || queueCount > 0 || requestedPortions > 0;
 }
 
 void FeedingService::startMovement(uint8_t target, bool feedSeq) {
@@ -50,181 +294,316 @@ void FeedingService::startMovement(uint8_t target, bool feedSeq) {
 
   targetPosition = target;
   isFeedSequence = feedSeq;
-  state = POWER_ON;
-  stateStartTime = millis();
+  enterState(POWER_ON, millis());
+}
+
+void FeedingService::startMoving(unsigned long now) {
+  if (targetPosition == openAngle && isFeedSequence) {
+    cycleStartTime = now;
+    if (hasLightBarrier()) portionStartPulses = lightBarrier->getPulseCount();
+  }
+
+  // Partial travel takes proportionally less time
+  uint8_t travel = targetPosition > position ? targetPosition - position : position - targetPosition;
+  uint16_t duration = (uint32_t)SERVO_TRAVEL_TIME * travel / 180;
+  if (duration < SERVO_MIN_TRAVEL_TIME) duration = SERVO_MIN_TRAVEL_TIME;
+  servos.moveTo(targetPosition, duration);
+  enterState(MOVING, now);
+}
+
+void FeedingService::enterState(ServoState next, unsigned long now) {
+  if (state != IDLE) {
+    recordTiming(metrics.states[state], now - stateStartTime);
+  }
+  state = next;
+  stateStartTime = now;
+}
+
+void FeedingService::recordTiming(TimingHistogram &histogram, uint32_t ms) {
+  uint8_t bucket = 0;
+  while (bucket < TIMING_BUCKET_COUNT - 1 && ms > TIMING_BUCKET_LIMITS_MS[bucket]) bucket++;
+  histogram.counts[bucket]++;
+  histogram.totalMs += ms;
+  if (ms > histogram.maxMs) histogram.maxMs = ms;
+  metricsDirty = true;
+}
+
+void FeedingService::loadMetrics(const FeedMetrics &stored) {
+  metrics = stored;
+  metricsDirty = false;
+}
+
+void FeedingService::resetMetrics() {
+  memset(&metrics, 0, sizeof(metrics));
+  metricsDirty = true;
+}
+
+void FeedingService::recordCycle(unsigned long now) {
+  uint32_t cycleMs = now - cycleStartTime;
+  cycleStats.cycles++;
+  cycleStats.lastCycleMs = cycleMs;
+  if (cycleStats.minCycleMs == 0 || cycleMs < cycleStats.minCycleMs) cycleStats.minCycleMs = cycleMs;
+  if (cycleMs > cycleStats.maxCycleMs) cycleStats.maxCycleMs = cycleMs;
+  recordTiming(metrics.portion, cycleMs);
+}
+
+bool FeedingService::hasLightBarrier() const {
+  return lightBarrier && lightBarrier->isPresent();
+}
+
+bool FeedingService::portionFilled() const {
+  return hasLightBarrier() && pulsesPerPortion > 0 &&
+         lightBarrier->getPulseCount() - portionStartPulses >= pulsesPerPortion;
+}
+
+// Called when a portion has closed; true ends the feed after it
+bool FeedingService::checkPortion() {
+  if (!hasLightBarrier()) return false;
+  if (dispenseStats.lastFault != DISPENSE_OK) {
+    // Jammed: the history gets what was dispensed, not what was asked for
+    feedCount = feedsCompleted;
+    return true;
+  }
+
+  uint32_t total = lightBarrier->getPulseCount();
+  uint32_t portionPulses = total - portionStartPulses;
+  dispenseStats.lastPulses = portionPulses > UINT16_MAX ? UINT16_MAX : portionPulses;
+
+  if (portionPulses == 0) {
+    dispenseStats.emptyPortions++;
+    emptyRun++;
+  } else {
+    emptyRun = 0;
+    if (pulsesPerPortion == 0) {
+      // Counting only
+    } else if (portionPulses < pulsesPerPortion) {
+      dispenseStats.shortPortions++;
+    } else {
+      dispenseStats.verifiedPortions++;
+    }
+  }
+  Serial.printf("[DEBUG] Light barrier: %lu pulses this portion, %lu this feed\n",
+                (unsigned long)portionPulses, (unsigned long)total);
+
+  if (emptyRun >= LIGHT_BARRIER_EMPTY_PORTIONS) {
+    failDispense(DISPENSE_EMPTY);
+    // Only the portions that actually dispensed go to the history
+    feedCount = feedsCompleted - emptyRun;
+    return true;
+  }
+
+  // A generous portion can make up for the next ones
+  if (pulsesPerPortion > 0 && feedsCompleted < feedCount && total >= (uint32_t)feedCount * pulsesPerPortion) {
+    Serial.printf("[INFO] Feed amount reached after %d of %d portions\n", feedsCompleted, feedCount);
+    dispenseStats.earlyFeedEnds++;
+    return true;
+  }
+  return false;
+}
+
+void FeedingService::checkJam() {
+  if (!hasLightBarrier() || dispenseStats.lastFault != DISPENSE_OK || !lightBarrier->isJammed()) return;
+  failDispense(DISPENSE_JAM);
+}
+
+void FeedingService::failDispense(DispenseFault fault) {
+  dispenseStats.lastFault = fault;
+  Serial.printf("[ERROR] %s - ending feed after this portion\n",
+                fault == DISPENSE_JAM ? "Light barrier blocked, outlet jammed" : "Nothing dispensed, hopper empty");
+
+  // Whatever is queued would fail the same way
+  if (queueCount > 0) {
+    Serial.printf("[WARN] Dropping %d queued feed requests\n", queueCount);
+    queueStats.dropped += queueCount;
+    queueCount = 0;
+  }
 }
 
 void FeedingService::open() {
-  startMovement(SERVO_MAX_ANGLE);
+  startMovement(openAngle);
 }
 
 void FeedingService::close() {
-  startMovement(SERVO_MIN_ANGLE);
+  startMovement(closeAngle);
 }
 
 void FeedingService::update() {
+  if (pendingCalibration != CALIBRATION_NONE) {
+    CalibrationCommand command = pendingCalibration;
+    pendingCalibration = CALIBRATION_NONE;
+    runCalibration(command);
+  }
+
+  portENTER_CRITICAL(&requestMux);
+  uint8_t requested = requestedPortions;
+  FeedSource requestedBy = requestedSource;
+  requestedPortions = 0;
+  portEXIT_CRITICAL(&requestMux);
+  if (requested > 0) {
+    feed(requested, requestedBy);
+  }
+
   unsigned long currentTime = millis();
   unsigned long elapsed = currentTime - stateStartTime;
 
+  if (isFeedSequence && (state == MOVING || state == FEED_WAITING)) {
+    checkJam();
+  }
+
   switch (state) {
-    case IDLE:
-      // Nothing to do
+    case IDLE: {
+      // Queue left over from an aborted feed
+      FeedRequest next;
+      if (dequeue(next)) {
+        startSequence(next.portions, false, 0);
+      } else {
+        flushFeedLog();
+      }
+      break;
+    }
+
+    case PRE_AGITATE:
+      if (elapsed >= agitationLeadMs) {
+        enterState(POWER_ON, currentTime);
+      }
       break;
 
     case POWER_ON:
       // Turn on transistor and wait for servos to initialize
       digitalWrite(TRANSISTOR_PIN, HIGH);
-      state = ATTACH_SERVOS;
-      stateStartTime = currentTime;
+      enterState(ATTACH_SERVOS, currentTime);
       Serial.println("[DEBUG] Power ON");
       break;
 
     case ATTACH_SERVOS:
       if (elapsed >= POWER_ON_DELAY) {
-        // Attach servos
-        servo1.attach(SERVO1_PIN, 500, 2400);
-        servo2.attach(SERVO2_PIN, 500, 2400);
-
-        if (!servo1.attached() || !servo2.attached()) {
+        if (!servos.attach()) {
           Serial.println("[ERROR] Servo attach failed - aborting feed cycle");
           digitalWrite(TRANSISTOR_PIN, LOW);
           if (vibrationService) {
             vibrationService->endFeedShake(0);
           }
-          state = IDLE;
+          if (hasLightBarrier()) {
+            lightBarrier->disarm();
+          }
+          enterState(IDLE, currentTime);
           isFeedSequence = false;
+          holdOpen = false;
           // Do NOT call recordFeedEvent() - nothing was actually dispensed
           break;
         }
 
-        // Start at current position (will move stepwise to target)
-        currentStepPosition = position;
-        servo1.write(SERVO_MAX_ANGLE - currentStepPosition);
-        servo2.write(currentStepPosition);
+        // Hold the current position; the move to the target is profiled
+        servos.write(position);
 
-        state = SERVO_READY;
-        stateStartTime = currentTime;
-        Serial.printf("[DEBUG] Servos attached at position %d, will move to %d in steps\n",
-                      currentStepPosition, targetPosition);
+        enterState(SERVO_READY, currentTime);
+        Serial.printf("[DEBUG] Servos attached at position %d, will move to %d\n",
+                      position, targetPosition);
       }
       break;
 
     case SERVO_READY:
-      if (elapsed >= SERVO_ATTACH_DELAY) {
+      if (elapsed >= SERVO_ATTACH_DELAY && !holdOpen) {
         // Extra stabilization time - servos should now be at target
-        state = MOVING;
-        stateStartTime = currentTime;
+        startMoving(currentTime);
         Serial.println("[DEBUG] Servos stabilizing");
       }
       break;
 
     case MOVING:
-      if (elapsed >= STEP_DELAY) {
-        // Calculate next step
-        if (currentStepPosition != targetPosition) {
-          // Move one step towards target
-          if (currentStepPosition < targetPosition) {
-            // Moving up (opening)
-            if (currentStepPosition + STEP_SIZE >= targetPosition) {
-              currentStepPosition = targetPosition;
-            } else {
-              currentStepPosition += STEP_SIZE;
-            }
-          } else {
-            // Moving down (closing)
-            if (currentStepPosition <= targetPosition + STEP_SIZE) {
-              currentStepPosition = targetPosition;
-            } else {
-              currentStepPosition -= STEP_SIZE;
-            }
+      // ServoDriver runs the profile; just wait for it to finish
+      if (!servos.isMoving()) {
+        position = targetPosition;
+
+        // In a feed sequence the servos stay powered and attached from
+        // the first opening to the last closing; only the moves and the
+        // dwell in between repeat
+        ServoState next = DETACH_SERVOS;
+        if (isFeedSequence && targetPosition == openAngle) {
+          next = FEED_WAITING;
+          Serial.println("[DEBUG] Open, waiting before close");
+        } else if (isFeedSequence) {
+          feedsCompleted++;
+          recordCycle(currentTime);
+          Serial.printf("[DEBUG] Completed feeding %d/%d in %lu ms\n",
+                        feedsCompleted, feedCount, (unsigned long)cycleStats.lastCycleMs);
+          // The light barrier can end a feed early: amount reached, or
+          // nothing more will come out
+          bool done = checkPortion();
+          if (feedsCompleted < feedCount && !done) {
+            next = FEED_WAITING;
+          } else if (queueCount > 0) {
+            // Next job straight away: servos stay up, vibration keeps going.
+            // Recorded first, while the source is still this job's
+            cycleStats.lastSequenceMs = currentTime - sequenceStartTime;
+            cycleStats.lastSequencePortions = feedsCompleted;
+            recordFeedEvent();
+            FeedRequest request;
+            dequeue(request);
+            beginJob(request.portions, 0);
+            next = FEED_WAITING;
           }
-
-          // CRITICAL: Write both servos at EXACTLY the same time for synchronous movement
-          // servo1 rotates opposite direction, servo2 normal direction
-          servo1.write(SERVO_MAX_ANGLE - currentStepPosition);
-          servo2.write(currentStepPosition);
-
-          // Reset timer for next step
-          stateStartTime = currentTime;
-
-          Serial.printf("[DEBUG] Moving step: %d -> target: %d\n", currentStepPosition, targetPosition);
         } else {
-          // Target reached, move to detach
-          position = targetPosition;
-          state = DETACH_SERVOS;
-          stateStartTime = currentTime;
           Serial.println("[DEBUG] Movement complete");
         }
+        enterState(next, currentTime);
       }
       break;
 
     case DETACH_SERVOS:
-      servo1.detach();
-      servo2.detach();
-      state = POWER_OFF;
-      stateStartTime = currentTime;
+      servos.detach();
+      enterState(POWER_OFF, currentTime);
       Serial.println("[DEBUG] Servos detached");
       break;
 
     case POWER_OFF:
       digitalWrite(TRANSISTOR_PIN, LOW);
+      enterState(IDLE, currentTime);
+      if (hasLightBarrier()) {
+        lightBarrier->disarm();
+      }
 
-      // DEBUG: Log state before checking conditions
-      Serial.printf("[DEBUG] POWER_OFF: isFeedSequence=%d, targetPosition=%d, feedsCompleted=%d/%d, time=%lu\n",
-                    isFeedSequence, targetPosition, feedsCompleted, feedCount, millis());
-
-      // Check if this was part of a feed sequence and we just finished opening
-      if (isFeedSequence && targetPosition == SERVO_MAX_ANGLE) {
-        // We just finished opening, now wait before close
-        state = FEED_WAITING;
-        stateStartTime = currentTime;
-        Serial.printf("[DEBUG] Power OFF, waiting before close (start_time=%lu)\n", currentTime);
-      } else if (isFeedSequence && targetPosition == SERVO_MIN_ANGLE) {
-        // We just finished closing, check if we need more feedings
-        feedsCompleted++;
-        Serial.printf("[DEBUG] Completed feeding %d/%d\n", feedsCompleted, feedCount);
-
-        if (feedsCompleted < feedCount) {
-          // Start next feeding cycle
-          Serial.printf("[DEBUG] Starting next portion (start_time=%lu)\n", currentTime);
-          state = FEED_WAITING;
-          stateStartTime = currentTime;
-        } else {
-          // All feedings complete
-          state = IDLE;
-          isFeedSequence = false;
-          recordFeedEvent();
-          if (vibrationService) {
-            vibrationService->endFeedShake(POST_FEED_VIBRATION_TAIL_MS);
-          }
-          Serial.println("[DEBUG] All portions complete");
-        }
+      if (isFeedSequence) {
+        // Last portion closed
+        cycleStats.lastSequenceMs = currentTime - sequenceStartTime;
+        cycleStats.lastSequencePortions = feedsCompleted;
+        Serial.printf("[DEBUG] All portions complete: %d in %lu ms\n",
+                      feedsCompleted, (unsigned long)cycleStats.lastSequenceMs);
       } else {
-        // Normal movement complete
-        state = IDLE;
-        isFeedSequence = false;
-        recordFeedEvent();
-        if (vibrationService) {
-          vibrationService->endFeedShake(POST_FEED_VIBRATION_TAIL_MS);
-        }
         Serial.println("[DEBUG] Power OFF, sequence complete");
       }
+
+      isFeedSequence = false;
+      recordFeedEvent();
+      if (vibrationService) {
+        vibrationService->endFeedShake(POST_FEED_VIBRATION_TAIL_MS);
+      }
       break;
 
     case FEED_WAITING:
-      if (elapsed >= FEED_WAIT_TIME) {
-        // Wait time over
-        if (targetPosition == SERVO_MAX_ANGLE) {
-          // We were open, now close
+      if (targetPosition == openAngle && elapsed < openDwellMs && portionFilled()) {
+        // A full unit has passed the barrier already
+        dispenseStats.earlyCloses++;
+        Serial.printf("[DEBUG] Portion complete after %lu ms, closing early\n", elapsed);
+        targetPosition = closeAngle;
+        startMoving(currentTime);
+      } else if (targetPosition == openAngle && dispenseStats.lastFault == DISPENSE_JAM) {
+        targetPosition = closeAngle;
+        startMoving(currentTime);
+      } else if (dispenseStats.lastFault == DISPENSE_JAM) {
+        // Closed, don't open again
+        feedCount = feedsCompleted;
+        enterState(DETACH_SERVOS, currentTime);
+      } else if (elapsed >= (targetPosition == openAngle ? openDwellMs : portionGapMs)) {
+        // Servos are still attached - move straight away
+        if (targetPosition == openAngle) {
           Serial.printf("[DEBUG] Wait complete (%lu ms), closing\n", elapsed);
-          targetPosition = SERVO_MIN_ANGLE;
+          targetPosition = closeAngle;
         } else {
-          // We were closed, now open for next portion
           Serial.printf("[DEBUG] Wait complete (%lu ms), opening for next portion\n", elapsed);
-          targetPosition = SERVO_MAX_ANGLE;
+          targetPosition = openAngle;
         }
-        state = POWER_ON;
-        stateStartTime = currentTime;
+        startMoving(currentTime);
       }
       break;
   }
@@ -235,6 +614,11 @@ uint8_t FeedingService::getPosition() {
 }
 
 void FeedingService::recordFeedEvent() {
+  if (calibrationTrial) {
+    Serial.println("[INFO] Calibration portion done - not a feed, not recorded");
+    return;
+  }
+
   if (clockService) {
     DateTime now = clockService->now();
     if (!now.isValid()) {
@@ -246,25 +630,34 @@ void FeedingService::recordFeedEvent() {
     Serial.printf("[INFO] Feed event recorded at %04u-%02u-%02u %02u:%02u:%02u\n",
                   now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second());
 
-    // Add to feed history
-    addFeedToHistory(lastFeedUnix, feedCount);
+    // Add to feed history, in grams at today's portion size
+    uint16_t grams = configService ? feedCount * configService->getPortionUnitGrams() : 0;
+    addFeedToHistory(lastFeedUnix, grams, historyTag());
   } else {
     lastFeedUnix = 0;
     Serial.println("[WARN] ClockService unavailable, last feed time not recorded");
   }
 }
 
-void FeedingService::addFeedToHistory(uint32_t timestamp, uint8_t portionUnits) {
-  Serial.printf("[DEBUG] addFeedToHistory called: timestamp=%lu, portionUnits=%d, current index=%d\n",
-                timestamp, portionUnits, feedHistoryIndex);
+uint8_t FeedingService::historyTag() const {
+  switch (currentSource) {
+    case FEED_SOURCE_BUTTON: return FEED_TAG_BUTTON;
+    case FEED_SOURCE_SCHEDULE:
+      if (currentScheduleId > 0 && currentScheduleId <= MAX_SCHEDULES) return FEED_TAG_SCHEDULE_ID(currentScheduleId);
+      return FEED_TAG_SCHEDULE;
+    default: return FEED_TAG_WEB;
+  }
+}
 
-  // Add entry to ring buffer
-  feedHistory[feedHistoryIndex].timestamp = timestamp;
-  feedHistory[feedHistoryIndex].portion_units = portionUnits;
+void FeedingService::addFeedToHistory(uint32_t timestamp, uint16_t grams, uint8_t tag) {
+  Serial.printf("[DEBUG] addFeedToHistory called: timestamp=%lu, grams=%d, tag=%d, current index=%d\n",
+                timestamp, grams, tag, feedHistoryIndex);
 
-  Serial.printf("[DEBUG] Stored at index %d: timestamp=%lu, portion_units=%d\n",
-                feedHistoryIndex, feedHistory[feedHistoryIndex].timestamp,
-                feedHistory[feedHistoryIndex].portion_units);
+  // Add entry to ring buffer
+  FeedHistoryEntry &entry = feedHistory[feedHistoryIndex];
+  entry.timestamp = timestamp;
+  entry.grams = grams;
+  entry.tag = tag;
 
   // Move to next index (circular)
   feedHistoryIndex = (feedHistoryIndex + 1) % MAX_FEED_HISTORY;
@@ -274,16 +667,33 @@ void FeedingService::addFeedToHistory(uint32_t timestamp, uint8_t portionUnits)
     feedHistoryCount++;
   }
 
-  Serial.printf("[DEBUG] Feed added to history: %lu, %d units (count: %d, next index: %d)\n",
-                timestamp, portionUnits, feedHistoryCount, feedHistoryIndex);
+  Serial.printf("[DEBUG] Feed added to history: %lu, %d g (count: %d, next index: %d)\n",
+                timestamp, grams, feedHistoryCount, feedHistoryIndex);
 
-  // Immediately save to persistent storage
-  if (configService) {
+  // One record in the feed log, or the whole ring as an NVS blob that
+  // ConfigService writes behind; either way once the feeder is idle
+  if (feedLog && feedLog->isAvailable()) {
+    if (pendingLogCount == sizeof(pendingLog) / sizeof(pendingLog[0])) {
+      Serial.println("[WARN] Feed log backlog full, appending now");
+      flushFeedLog();
+    }
+    pendingLog[pendingLogCount++] = entry;
+  } else if (configService) {
     configService->saveFeedHistory(feedHistory, feedHistoryCount, feedHistoryIndex);
-    Serial.println("[INFO] Feed history saved to NVS");
   }
 }
 
+void FeedingService::flushFeedLog() {
+  if (pendingLogCount == 0) return;
+
+  if (feedLog && feedLog->isAvailable()) {
+    for (uint8_t i = 0; i < pendingLogCount; i++) {
+      feedLog->append(pendingLog[i]);
+    }
+  }
+  pendingLogCount = 0;
+}
+
 uint8_t FeedingService::getFeedHistoryCount() const {
   return feedHistoryCount;
 }
@@ -298,8 +708,8 @@ void FeedingService::loadFeedHistory(const FeedHistoryEntry* history, uint8_t co
 
   for (uint8_t i = 0; i < count; i++) {
     feedHistory[i] = history[i];
-    Serial.printf("[DEBUG] Loaded entry %d: timestamp=%lu, portion_units=%d\n",
-                  i, feedHistory[i].timestamp, feedHistory[i].portion_units);
+    Serial.printf("[DEBUG] Loaded entry %d: timestamp=%lu, grams=%d, tag=%d\n",
+                  i, feedHistory[i].timestamp, feedHistory[i].grams, feedHistory[i].tag);
   }
 
   feedHistoryCount = count;
@@ -317,9 +727,41 @@ void FeedingService::loadFeedHistory(const FeedHistoryEntry* history, uint8_t co
                 count, feedHistoryIndex, lastFeedUnix);
 }
 
+uint16_t FeedingService::readFeedHistory(FeedHistoryEntry* out, uint16_t maxCount, uint16_t skip) const {
+  if (feedLog && feedLog->isAvailable()) {
+    return feedLog->readRecent(out, maxCount, skip);
+  }
+
+  uint16_t count = 0;
+  for (uint16_t i = skip; i < feedHistoryCount && count < maxCount; i++) {
+    const FeedHistoryEntry &entry = feedHistory[(feedHistoryIndex + MAX_FEED_HISTORY - 1 - i) % MAX_FEED_HISTORY];
+    if (entry.timestamp == 0) continue;
+    out[count++] = entry;
+  }
+  return count;
+}
+
+uint32_t FeedingService::getGramsBetween(uint32_t fromUtc, uint32_t toUtc) const {
+  if (feedLog && feedLog->isAvailable()) {
+    return feedLog->sumGrams(fromUtc, toUtc);
+  }
+
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < feedHistoryCount; i++) {
+    if (feedHistory[i].timestamp >= fromUtc && feedHistory[i].timestamp < toUtc) {
+      total += feedHistory[i].grams;
+    }
+  }
+  return total;
+}
+
 void FeedingService::clearFeedHistory() {
   feedHistoryCount = 0;
   feedHistoryIndex = 0;
   memset(feedHistory, 0, sizeof(feedHistory));
+  pendingLogCount = 0;
+  if (feedLog && feedLog->isAvailable()) {
+    feedLog->clear();
+  }
   Serial.println("[INFO] Feed history cleared");
 }
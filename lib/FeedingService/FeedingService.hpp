@@ -1,36 +1,112 @@
 #ifndef FEEDING_SERVICE_HPP
 #define FEEDING_SERVICE_HPP
 
-#include <ESP32Servo.h>
-
 #include "ButtonService.hpp"
 #include "ClockService.hpp"
+#include "ConfigService.hpp"
 #include "VibrationService.hpp"
+#include "LightBarrierService.hpp"
+#include "FeedLogService.hpp"
+#include "ServoDriver.hpp"
 #include "PinConfig.h"
 
-// Forward declarations
-class ConfigService;
-
-#define MAX_FEED_HISTORY 10
-
-struct FeedHistoryEntry {
-  uint32_t timestamp;  // Unix timestamp
-  uint8_t portion_units;  // Number of portion units fed
-};
-
 #define SERVO_MIN_ANGLE 0
 #define SERVO_MAX_ANGLE 180
 
 // Timing constants (in milliseconds)
 #define POWER_ON_DELAY 100     // Time to wait after powering on servos
 #define SERVO_ATTACH_DELAY 100 // Time to wait after attaching servos before sending position
-#define SERVO_MOVE_TIME 620    // Time for servos to complete movement (legacy, not used with stepwise movement)
-#define FEED_WAIT_TIME 1000    // Time to wait between open and close during feed
+#define SERVO_TRAVEL_TIME 450  // Profiled 180° move, driven by ServoDriver; shorter travel is quicker
+#define SERVO_MIN_TRAVEL_TIME 150
+// Power-on until the servos can move; pre-agitation overlaps with it
+#define SERVO_POWER_UP_TIME (POWER_ON_DELAY + SERVO_ATTACH_DELAY)
+// The open dwell and the closed gap between portions come from ConfigService
+
+// Calibration bisects the opening angle until the bracket is this narrow
+#define CALIBRATION_RESOLUTION_DEG 5
+
+#define FEED_QUEUE_SIZE 4
+
+// Who asked for a feed. Doubles as the queue priority, highest last: a
+// scheduled feed is the one that must not get lost.
+enum FeedSource : uint8_t {
+  FEED_SOURCE_WEB = 0,
+  FEED_SOURCE_BUTTON = 1,
+  FEED_SOURCE_SCHEDULE = 2
+};
+
+enum FeedRequestResult : uint8_t {
+  FEED_STARTED,   // Feeder was idle
+  FEED_QUEUED,    // Runs after the current feed and any higher-priority ones
+  FEED_MERGED,    // Folded into a feed already running or queued
+  FEED_REJECTED   // Queue full of equal or higher priority, or a hold while busy
+};
+
+struct FeedRequest {
+  uint8_t portions;
+  FeedSource source;
+  unsigned long queuedAt;  // millis()
+  uint8_t scheduleId;      // 0: not a schedule, or several merged
+};
+
+struct FeedQueueStats {
+  uint32_t queued;       // Requests that had to wait
+  uint32_t merged;
+  uint32_t dropped;      // Rejected, or displaced by a higher priority
+  uint32_t lastWaitMs;   // Queued until started, last dequeued request
+  uint32_t maxWaitMs;
+};
 #define POST_FEED_VIBRATION_TAIL_MS 2000  // Vibration tail after feed sequence completes
 
-// Stepwise movement constants
-#define STEP_SIZE 30           // Degrees per step
-#define STEP_DELAY 100          // Milliseconds between steps
+// Dispensing cycle timing, for checking how long large feeds take
+struct FeedCycleStats {
+  uint32_t cycles;           // Portions dispensed since boot
+  uint32_t lastCycleMs;      // Open start until closed again, last portion
+  uint32_t minCycleMs;
+  uint32_t maxCycleMs;
+  uint32_t lastSequenceMs;   // feed() until the servos powered off, last feed
+  uint8_t lastSequencePortions;
+};
+
+// Consecutive portions without a single light barrier pulse before the
+// hopper is taken as empty
+#define LIGHT_BARRIER_EMPTY_PORTIONS 2
+
+enum DispenseFault : uint8_t {
+  DISPENSE_OK,
+  DISPENSE_EMPTY,  // Nothing passed the light barrier
+  DISPENSE_JAM     // Beam blocked for LIGHT_BARRIER_JAM_MS
+};
+
+// Light barrier verification, per portion; all zero without a barrier
+struct DispenseStats {
+  uint32_t verifiedPortions;  // At least the configured pulses per portion
+  uint32_t shortPortions;     // Some feed, but less than a full unit
+  uint32_t emptyPortions;     // No pulse at all
+  uint32_t earlyCloses;       // Closed before the dwell ran out, portion complete
+  uint32_t earlyFeedEnds;     // Remaining portions skipped, feed amount reached
+  uint16_t lastPulses;        // Pulses of the last portion
+  DispenseFault lastFault;    // Of the last feed, cleared when the next starts
+};
+
+// Interactive search for the smallest opening that still dispenses a full
+// unit: each trial dispenses one portion, the user reports the result
+struct ServoCalibration {
+  bool active;
+  uint8_t lowAngle;    // Largest opening known to dispense too little
+  uint8_t highAngle;   // Smallest opening known to dispense a full unit
+  uint8_t testAngle;   // Opening of the current trial
+  uint8_t trials;
+};
+
+// Calibration steps from the web UI, carried out by update() on the loop task
+enum CalibrationCommand : uint8_t {
+  CALIBRATION_NONE,
+  CALIBRATION_START,
+  CALIBRATION_FULL_UNIT,   // The last test portion was a full unit
+  CALIBRATION_TOO_LITTLE,
+  CALIBRATION_CANCEL
+};
 
 enum ServoState {
   IDLE,
@@ -40,56 +116,181 @@ enum ServoState {
   MOVING,
   DETACH_SERVOS,
   POWER_OFF,
-  FEED_WAITING   // Waiting between open and close during feed sequence
+  FEED_WAITING,  // Waiting between open and close during feed sequence
+  PRE_AGITATE    // Vibration loosening the feed before the servos power up
+};
+#define SERVO_STATE_COUNT (PRE_AGITATE + 1)
+
+// Fixed latency buckets, upper bounds in ms; the last bucket is open-ended
+#define TIMING_BUCKET_COUNT 12
+static const uint16_t TIMING_BUCKET_LIMITS_MS[TIMING_BUCKET_COUNT - 1] = {
+  10, 20, 50, 100, 200, 500, 1000, 1500, 2000, 3000, 5000
+};
+
+struct TimingHistogram {
+  uint32_t counts[TIMING_BUCKET_COUNT];
+  uint32_t totalMs;
+  uint32_t maxMs;
+};
+
+// Field timing data for tuning the constants above; kept in RAM and
+// saved to NVS before deep sleep
+struct FeedMetrics {
+  TimingHistogram states[SERVO_STATE_COUNT];  // Time spent in each state, IDLE unused
+  TimingHistogram portion;                    // Opening starts until closed again
 };
 
 class FeedingService {
 public:
   FeedingService();
   void setup();
-  void feed(uint8_t count = 1);  // Feed with count portions (1-10)
+  // Feed count portions (1-10): starts at once when idle, otherwise goes
+  // to a bounded queue drained back-to-back with the servos kept up.
+  // Merge rules: a request from a source that already has one queued is
+  // folded into it (schedules add up, manual feeds keep the larger
+  // count), and a manual request while the same source's manual feed is
+  // running counts as a repeated click. A full queue lets a higher
+  // priority displace the newest lowest-priority entry. scheduleId only
+  // goes into the history record.
+  FeedRequestResult feed(uint8_t count, FeedSource source, bool hold = false, uint8_t scheduleId = 0);
   void update();  // Must be called in loop()
 
+  // feed() from another task (the web server): handed to the next
+  // update(), so the queue and the state machine are only ever changed
+  // from loop(). Requests before then fold into one, keeping the larger
+  // count and the higher priority.
+  void requestFeed(uint8_t count, FeedSource source);
+
+  // A held feed powers and attaches the servos, then waits until release()
+  // so the hopper can open on an exact instant
+  bool isReadyToOpen() const;
+  void release();
+
   uint8_t getPosition();
-  bool isFeeding();  // Check if currently in a feed sequence
+  bool isFeeding();  // Check if currently in a feed sequence or one is queued
+  bool isHolding() const { return holdOpen; }
+  uint8_t getQueueDepth() const { return queueCount; }
+  uint32_t getOldestQueuedWaitMs() const;
+  const FeedQueueStats& getQueueStats() const { return queueStats; }
   uint32_t getLastFeedTimestamp() const { return lastFeedUnix; }
   void recordFeedEvent(); // Manually record feed completion (e.g., if needed)
   void setClockService(ClockService* clock) { clockService = clock; }
   void setConfigService(ConfigService* config) { configService = config; }
   void setVibrationService(VibrationService* vibration) { vibrationService = vibration; }
+  void setLightBarrierService(LightBarrierService* barrier) { lightBarrier = barrier; }
+  // With a feed log every feed is appended there instead of rewriting
+  // the NVS history blob; the RAM ring keeps the newest entries either way
+  void setFeedLogService(FeedLogService* log) { feedLog = log; }
 
   // Feed history management
-  void addFeedToHistory(uint32_t timestamp, uint8_t portionUnits);
+  void addFeedToHistory(uint32_t timestamp, uint16_t grams, uint8_t tag);
+  // Appends the records held back while the feeder was busy; update()
+  // calls it once idle, call it before sleeping or restarting
+  void flushFeedLog();
   uint8_t getFeedHistoryCount() const;
   const FeedHistoryEntry* getFeedHistory() const { return feedHistory; }
   uint8_t getFeedHistoryWriteIndex() const { return feedHistoryIndex; }
   void loadFeedHistory(const FeedHistoryEntry* history, uint8_t count, uint8_t writeIndex);
   void clearFeedHistory();
+  // Newest first from the feed log, or from the RAM ring without one
+  uint16_t readFeedHistory(FeedHistoryEntry* out, uint16_t maxCount, uint16_t skip = 0) const;
+  uint32_t getGramsBetween(uint32_t fromUtc, uint32_t toUtc) const;
+
+  const FeedCycleStats& getCycleStats() const { return cycleStats; }
+  const DispenseStats& getDispenseStats() const { return dispenseStats; }
+
+  // Per-state and per-portion timing histograms
+  const FeedMetrics& getMetrics() const { return metrics; }
+  bool isMetricsDirty() const { return metricsDirty; }
+  void markMetricsSaved() { metricsDirty = false; }
+  void loadMetrics(const FeedMetrics &stored);
+  void resetMetrics();
+
+  // Opening angle calibration. A request is handed to the next update(),
+  // so the state machine is only ever driven from loop(). Start and a
+  // result are refused while a feed is running or queued, a result also
+  // without an active calibration, and any request while one is pending.
+  bool requestCalibration(CalibrationCommand command);
+  bool isCalibrationPending() const { return pendingCalibration != CALIBRATION_NONE; }
+  const ServoCalibration& getCalibration() const { return calibration; }
 
 private:
   uint8_t position = 0;
   uint8_t targetPosition = 0;
-  uint8_t currentStepPosition = 0;  // Current position during stepwise movement
   bool isFeedSequence = false;  // Track if we're in a feed sequence
+  bool holdOpen = false;        // Stay in SERVO_READY until release()
   uint8_t feedCount = 0;         // Remaining feedings in sequence
   uint8_t feedsCompleted = 0;    // Completed feedings in sequence
 
-  Servo servo1 = Servo();
-  Servo servo2 = Servo();
+  // Endpoints and dwells, taken from ConfigService when a feed starts
+  uint8_t openAngle = SERVO_MAX_ANGLE;
+  uint8_t closeAngle = SERVO_MIN_ANGLE;
+  uint16_t openDwellMs = DEFAULT_OPEN_DWELL_MS;
+  uint16_t portionGapMs = DEFAULT_PORTION_GAP_MS;
+  uint8_t pulsesPerPortion = 0;          // 0: count only, don't verify
+  uint16_t agitationLeadMs = 0;          // PRE_AGITATE time before POWER_ON
+  ServoCalibration calibration = {};
+  volatile CalibrationCommand pendingCalibration = CALIBRATION_NONE;
+  portMUX_TYPE requestMux = portMUX_INITIALIZER_UNLOCKED;
+  uint8_t requestedPortions = 0;  // 0: no requestFeed() pending
+  FeedSource requestedSource = FEED_SOURCE_WEB;
+  bool calibrationTrial = false;  // The running job is a test portion, not a feed
+
+  // Pending requests, highest priority first, FIFO within a priority
+  FeedRequest queue[FEED_QUEUE_SIZE];
+  uint8_t queueCount = 0;
+  FeedSource currentSource = FEED_SOURCE_WEB;
+  uint8_t currentScheduleId = 0;
+  FeedQueueStats queueStats = {};
+
+  ServoDriver servos = ServoDriver(SERVO1_PIN, SERVO2_PIN);
 
   ServoState state = IDLE;
   unsigned long stateStartTime = 0;
+  unsigned long cycleStartTime = 0;     // Current portion started opening
+  unsigned long sequenceStartTime = 0;  // feed() was called
+  FeedCycleStats cycleStats = {};
+  DispenseStats dispenseStats = {};
+  uint32_t portionStartPulses = 0;  // Barrier count when the current portion opened
+  uint8_t emptyRun = 0;             // Consecutive portions without a pulse
+  FeedMetrics metrics = {};
+  bool metricsDirty = false;
   uint32_t lastFeedUnix = 0;
   ClockService* clockService = nullptr;
   ConfigService* configService = nullptr;
   VibrationService* vibrationService = nullptr;
+  LightBarrierService* lightBarrier = nullptr;
+  FeedLogService* feedLog = nullptr;
 
   // Feed history (ring buffer)
   FeedHistoryEntry feedHistory[MAX_FEED_HISTORY];
   uint8_t feedHistoryCount = 0;  // Number of valid entries (0-10)
   uint8_t feedHistoryIndex = 0;  // Next write index (circular)
 
+  // Feed log records waiting for the feeder to go idle: a flash write
+  // must not stall a chained feed
+  FeedHistoryEntry pendingLog[FEED_QUEUE_SIZE + 1];
+  uint8_t pendingLogCount = 0;
+
+  void runCalibration(CalibrationCommand command);
+  bool startCalibration();
+  bool reportCalibration(bool fullUnit);
+  void cancelCalibration();
+  void startSequence(uint8_t count, bool hold, uint8_t openOverride);
+  void beginJob(uint8_t count, uint8_t openOverride);
+  FeedRequestResult enqueue(uint8_t count, FeedSource source, uint8_t scheduleId);
+  uint8_t historyTag() const;
+  bool dequeue(FeedRequest &request);
   void startMovement(uint8_t target, bool feedSeq = false);
+  void startMoving(unsigned long now);
+  void enterState(ServoState next, unsigned long now);
+  void recordTiming(TimingHistogram &histogram, uint32_t ms);
+  void recordCycle(unsigned long now);
+  bool hasLightBarrier() const;
+  bool portionFilled() const;
+  bool checkPortion();
+  void checkJam();
+  void failDispense(DispenseFault fault);
   void open();
   void close();
 };
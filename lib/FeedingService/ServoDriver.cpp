@@ -0,0 +1,113 @@
+#include "ServoDriver.hpp"
+
+static const uint32_t FULL_TRAVEL_Q10 = 180UL * 1024;
+
+ServoDriver::ServoDriver(uint8_t pin1, uint8_t pin2)
+  : pin1(pin1), pin2(pin2), isAttached(false), frameTimer(nullptr),
+    profile(&SERVO_PROFILE_SCURVE), moveStartUs(0), moveDurationUs(0),
+    fromAngle(0), toAngle(0), moving(false) {}
+
+bool ServoDriver::attach() {
+  if (isAttached) return true;
+
+  // Created on first use - esp_timer isn't up yet when globals are constructed
+  if (!frameTimer) {
+    esp_timer_create_args_t args = {};
+    args.callback = &ServoDriver::onFrame;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "servo";
+    if (esp_timer_create(&args, &frameTimer) != ESP_OK) {
+      frameTimer = nullptr;
+      return false;
+    }
+  }
+
+  if (!ledcAttach(pin1, SERVO_PWM_FREQUENCY, SERVO_PWM_RESOLUTION)) return false;
+  if (!ledcAttach(pin2, SERVO_PWM_FREQUENCY, SERVO_PWM_RESOLUTION)) {
+    ledcDetach(pin1);
+    return false;
+  }
+  isAttached = true;
+  return true;
+}
+
+void ServoDriver::detach() {
+  if (frameTimer) esp_timer_stop(frameTimer);
+  moving = false;
+  if (!isAttached) return;
+
+  ledcDetach(pin1);
+  ledcDetach(pin2);
+  isAttached = false;
+}
+
+void ServoDriver::write(uint8_t angle) {
+  if (angle > 180) angle = 180;
+  if (frameTimer) esp_timer_stop(frameTimer);
+  moving = false;
+  fromAngle = toAngle = angle;
+  writeAngleQ10((uint32_t)angle * 1024);
+}
+
+void ServoDriver::moveTo(uint8_t angle, uint16_t durationMs, const ServoProfile &moveProfile) {
+  if (angle > 180) angle = 180;
+  if (!isAttached || !frameTimer || durationMs == 0 || angle == toAngle) {
+    write(angle);
+    return;
+  }
+
+  esp_timer_stop(frameTimer);
+  profile = &moveProfile;
+  fromAngle = toAngle;
+  toAngle = angle;
+  moveDurationUs = (uint32_t)durationMs * 1000;
+  moveStartUs = esp_timer_get_time();
+  moving = true;
+
+  // From the next frame on the callback takes over
+  esp_timer_start_periodic(frameTimer, SERVO_FRAME_US);
+}
+
+void ServoDriver::onFrame(void *arg) {
+  static_cast<ServoDriver*>(arg)->step();
+}
+
+void ServoDriver::step() {
+  if (!moving) return;
+
+  uint32_t elapsed = (uint32_t)(esp_timer_get_time() - moveStartUs);
+  if (elapsed >= moveDurationUs) {
+    writeAngleQ10((uint32_t)toAngle * 1024);
+    esp_timer_stop(frameTimer);
+    moving = false;
+    return;
+  }
+
+  // Linear between the two table points around this frame
+  uint32_t pos = (uint32_t)((uint64_t)elapsed * SERVO_PROFILE_SEGMENTS * 1024 / moveDurationUs);
+  uint8_t segment = pos / 1024;
+  uint32_t within = pos % 1024;
+  uint32_t a = profile->points[segment];
+  uint32_t b = profile->points[segment + 1];
+  uint32_t fraction = a + (b - a) * within / 1024;  // 0-1024, never decreasing
+
+  int32_t travel = (int32_t)toAngle - (int32_t)fromAngle;
+  writeAngleQ10((uint32_t)((int32_t)fromAngle * 1024 + travel * (int32_t)fraction));
+}
+
+void ServoDriver::writeAngleQ10(uint32_t angleQ10) {
+  if (!isAttached) return;
+  if (angleQ10 > FULL_TRAVEL_Q10) angleQ10 = FULL_TRAVEL_Q10;
+
+  // Both duties land in the same frame: LEDC only applies them at the
+  // next period boundary
+  ledcWrite(pin1, dutyFor(FULL_TRAVEL_Q10 - angleQ10));
+  ledcWrite(pin2, dutyFor(angleQ10));
+}
+
+uint32_t ServoDriver::dutyFor(uint32_t angleQ10) {
+  uint64_t pulseNs = (uint64_t)SERVO_MIN_PULSE_US * 1000 +
+                     (uint64_t)(SERVO_MAX_PULSE_US - SERVO_MIN_PULSE_US) * 1000 * angleQ10 / FULL_TRAVEL_Q10;
+  return (uint32_t)(pulseNs * (1UL << SERVO_PWM_RESOLUTION) / ((uint64_t)SERVO_FRAME_US * 1000));
+}
@@ -0,0 +1,91 @@
+#ifndef SERVO_DRIVER_HPP
+#define SERVO_DRIVER_HPP
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// Standard hobby servo frame: one pulse every 20 ms, 500-2400 us for 0-180°
+#define SERVO_PWM_FREQUENCY 50
+#define SERVO_PWM_RESOLUTION 14       // ~1.2 us (~0.1°) per LSB at 50 Hz
+#define SERVO_MIN_PULSE_US 500
+#define SERVO_MAX_PULSE_US 2400
+#define SERVO_FRAME_US (1000000 / SERVO_PWM_FREQUENCY)
+
+#define SERVO_PROFILE_SEGMENTS 16
+
+// Fraction of the travel, in 1/1024, reached at the end of each of
+// SERVO_PROFILE_SEGMENTS equal time slices of a move
+struct ServoProfile {
+  uint16_t points[SERVO_PROFILE_SEGMENTS + 1];
+};
+
+// Minimum-jerk curve 10t³ - 15t⁴ + 6t⁵: zero speed and acceleration at
+// both ends, so the gate starts and stops without a knock
+constexpr ServoProfile makeSCurveProfile() {
+  ServoProfile profile = {};
+  for (uint8_t i = 0; i <= SERVO_PROFILE_SEGMENTS; i++) {
+    double t = (double)i / SERVO_PROFILE_SEGMENTS;
+    double s = t * t * t * (10 - 15 * t + 6 * t * t);
+    profile.points[i] = (uint16_t)(s * 1024 + 0.5);
+  }
+  return profile;
+}
+
+// Constant acceleration for the first and last quarter, cruise in between
+constexpr ServoProfile makeTrapezoidProfile() {
+  ServoProfile profile = {};
+  const double ramp = 0.25;
+  const double vmax = 1 / (1 - ramp);
+  for (uint8_t i = 0; i <= SERVO_PROFILE_SEGMENTS; i++) {
+    double t = (double)i / SERVO_PROFILE_SEGMENTS;
+    double s = t < ramp         ? vmax * t * t / (2 * ramp)
+             : t <= 1 - ramp    ? vmax * (t - ramp / 2)
+                                : 1 - vmax * (1 - t) * (1 - t) / (2 * ramp);
+    profile.points[i] = (uint16_t)(s * 1024 + 0.5);
+  }
+  return profile;
+}
+
+constexpr ServoProfile SERVO_PROFILE_SCURVE = makeSCurveProfile();
+constexpr ServoProfile SERVO_PROFILE_TRAPEZOID = makeTrapezoidProfile();
+
+// Drives the two hopper servos from LEDC. servo1 is mounted mirrored and
+// gets 180° - angle. A move is interpolated from a profile table and
+// written once per PWM frame by an esp_timer callback; LEDC latches the
+// new duty at the next frame boundary, so the pulse train is exact no
+// matter how busy loop() is.
+class ServoDriver {
+public:
+  ServoDriver(uint8_t pin1, uint8_t pin2);
+
+  bool attach();
+  void detach();
+  bool attached() const { return isAttached; }
+
+  // Jump to an angle (0-180) without a profile
+  void write(uint8_t angle);
+  // Start a profiled move from the last written angle; returns at once
+  void moveTo(uint8_t angle, uint16_t durationMs, const ServoProfile &profile = SERVO_PROFILE_SCURVE);
+  bool isMoving() const { return moving; }
+
+private:
+  const uint8_t pin1;
+  const uint8_t pin2;
+  bool isAttached;
+  esp_timer_handle_t frameTimer;
+
+  // Current move; written before the timer starts, read by onFrame()
+  const ServoProfile *profile;
+  int64_t moveStartUs;
+  uint32_t moveDurationUs;
+  uint8_t fromAngle;
+  uint8_t toAngle;
+  volatile bool moving;
+
+  static void onFrame(void *arg);
+  void step();
+  void writeAngleQ10(uint32_t angleQ10);  // Angle in 1/1024°
+  static uint32_t dutyFor(uint32_t angleQ10);
+};
+
+#endif // SERVO_DRIVER_HPP
@@ -0,0 +1,57 @@
+#include "LightBarrierService.hpp"
+
+LightBarrierService::LightBarrierService() {}
+
+void LightBarrierService::begin() {
+#if LIGHT_BARRIER_ENABLED
+  pinMode(LIGHT_BARRIER_PIN, INPUT);
+  blocked = digitalRead(LIGHT_BARRIER_PIN) == LIGHT_BARRIER_BLOCKED_LEVEL;
+  blockedSinceUs = micros();
+  attachInterruptArg(digitalPinToInterrupt(LIGHT_BARRIER_PIN), onBeamChange, this, CHANGE);
+
+  Serial.printf("[INFO] LightBarrierService initialized (beam %s).\n", blocked ? "blocked" : "clear");
+#else
+  Serial.println("[INFO] LightBarrierService disabled at compile time (LIGHT_BARRIER_ENABLED=0).");
+#endif
+}
+
+void LightBarrierService::arm() {
+  portENTER_CRITICAL(&mux);
+  pulses = 0;
+  armed = true;
+  portEXIT_CRITICAL(&mux);
+}
+
+void LightBarrierService::disarm() {
+  armed = false;
+}
+
+bool LightBarrierService::isJammed() const {
+  return blocked && micros() - blockedSinceUs >= (uint32_t)LIGHT_BARRIER_JAM_MS * 1000;
+}
+
+void LightBarrierService::simulateBeam(bool isBlocked) {
+  portENTER_CRITICAL(&mux);
+  handleEdge(isBlocked, micros());
+  portEXIT_CRITICAL(&mux);
+}
+
+void IRAM_ATTR LightBarrierService::onBeamChange(void *arg) {
+  LightBarrierService *self = static_cast<LightBarrierService*>(arg);
+  portENTER_CRITICAL_ISR(&self->mux);
+  self->handleEdge(digitalRead(LIGHT_BARRIER_PIN) == LIGHT_BARRIER_BLOCKED_LEVEL, micros());
+  portEXIT_CRITICAL_ISR(&self->mux);
+}
+
+void IRAM_ATTR LightBarrierService::handleEdge(bool isBlocked, uint32_t nowUs) {
+  // CHANGE also fires on glitches that end at the same level
+  if (isBlocked == blocked) return;
+  blocked = isBlocked;
+  if (!isBlocked) return;
+
+  blockedSinceUs = nowUs;
+  if (armed && nowUs - lastPulseUs >= LIGHT_BARRIER_DEBOUNCE_US) {
+    pulses = pulses + 1;
+  }
+  lastPulseUs = nowUs;
+}
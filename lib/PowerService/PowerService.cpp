@@ -0,0 +1,23 @@
+#include "PowerService.hpp"
+
+void PowerService::requestSleep(const char* reason) {
+  requestReason = reason;
+  deferred = false;
+}
+
+const char* PowerService::update(bool busy) {
+  if (!requestReason) return nullptr;
+
+  if (busy) {
+    if (!deferred) {
+      Serial.printf("[SLEEP] %s - deferred until the feed is done\n", requestReason);
+      deferred = true;
+    }
+    return nullptr;
+  }
+
+  const char* reason = requestReason;
+  requestReason = nullptr;
+  deferred = false;
+  return reason;
+}
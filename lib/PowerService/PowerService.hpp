@@ -0,0 +1,26 @@
+#ifndef POWER_SERVICE_HPP
+#define POWER_SERVICE_HPP
+
+#include <Arduino.h>
+
+// Manual and remote sleep requests (long press, POST /api/power/sleep).
+// Sleeping while a feed runs, or while an early alarm holds one for its
+// target second, would lose that feed - the scheduler's cursor has already
+// moved past a held batch, so the next alarm is armed for the one after.
+// A request made then is kept until the device is idle.
+class PowerService {
+public:
+  void requestSleep(const char* reason);
+  bool isSleepRequested() const { return requestReason != nullptr; }
+  void cancelSleep() { requestReason = nullptr; }
+
+  // Call from loop(); busy = a feed running, held or winding down. Returns
+  // the reason once a requested sleep may start, nullptr otherwise.
+  const char* update(bool busy);
+
+private:
+  const char* requestReason = nullptr;
+  bool deferred = false;
+};
+
+#endif // POWER_SERVICE_HPP
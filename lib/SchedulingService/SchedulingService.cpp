@@ -1,200 +1,554 @@
 #include "SchedulingService.hpp"
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+
+// Allow a small grace window so alarms that just fired are still considered "due"
+static const uint32_t GRACE_SECONDS = 60;
+
+// Bump the low byte whenever SchedulerSleepState changes layout, so an OTA
+// reboot (RTC memory survives ESP.restart()) never restores a foreign struct
+static const uint32_t SLEEP_STATE_MAGIC = 0x5C4ED005;
+
+// An alarm that fires early leaves the device holding the feed. Alarm 2
+// rounds down to the minute, so a hold can start up to a minute plus the
+// wake lead ahead.
+static const uint32_t HOLD_HORIZON_SECONDS = 120;
+
+// Wake budget before anything was measured, the slack kept on top of the
+// measured need, and how far the alarms may lead at most
+static const uint32_t DEFAULT_WAKE_BUDGET_US = 2000000;
+static const uint32_t WAKE_BUDGET_MARGIN_US = 250000;
+static const uint8_t MAX_WAKE_LEAD_SECONDS = 30;
+// A shorter need only lowers the budget by this fraction per wake, so one
+// fast boot doesn't undo the margin against a slow one
+static const uint32_t WAKE_BUDGET_DECAY = 8;
+
+static const uint32_t WAKE_TIMING_MAGIC = 0x3A4E0001;
+
+// Survives deep sleep; garbage after power-on, hence magic + CRC
+struct SchedulerSleepState {
+    uint32_t magic;
+    uint32_t configGeneration;
+    WeekSchedule week;
+    uint32_t weekCrc;  // Over week only, so it is redone only on a recompile
+    uint32_t weekFrom;
+    uint32_t weekUntil;
+    uint32_t weekRepeatUntil;
+    TimerEvent nextEvent;
+    bool hasNextEvent;
+    uint32_t armedAlarms[ClockService::ALARM_COUNT];
+    uint32_t crc;  // Over everything above except week
+};
+
+static RTC_DATA_ATTR SchedulerSleepState sleepState;
+
+struct WakeTimingState {
+    uint32_t magic;
+    WakeTiming timing;
+    uint32_t crc;
+};
+
+static RTC_DATA_ATTR WakeTimingState wakeTimingState;
+
+static uint32_t wakeTimingCrc(const WakeTimingState &state) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&state, offsetof(WakeTimingState, crc));
+}
+
+static uint32_t sleepStateCrc(const SchedulerSleepState &state) {
+    const uint8_t *bytes = (const uint8_t*)&state;
+    uint32_t crc = esp_rom_crc32_le(0, bytes, offsetof(SchedulerSleepState, week));
+    return esp_rom_crc32_le(crc, bytes + offsetof(SchedulerSleepState, weekCrc),
+                            offsetof(SchedulerSleepState, crc) - offsetof(SchedulerSleepState, weekCrc));
+}
+
+static uint32_t weekCrc(const WeekSchedule &week) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&week, sizeof(WeekSchedule));
+}
 
 SchedulingService::SchedulingService(ConfigService &config, ClockService &clock, FeedingService &feeding)
-    : configService(config), clockService(clock), feedingService(feeding), timerEventCount(0) {
+    : configService(config), clockService(clock), feedingService(feeding),
+      weekFrom(0), weekUntil(0), weekRepeatUntil(0), hasNextEvent(false),
+      configGeneration(0), compiledGeneration(0), weekSaved(false),
+      holdActive(false), holdWarming(false), holdOnWake(false),
+      bootStartUs(0), beginUs(0), loopStartUs(0), warmStartUs(0), readyUs(0) {
+    week.clear();
+    memset(armedAlarms, 0, sizeof(armedAlarms));
+    memset(&heldBatch, 0, sizeof(heldBatch));
+    memset(&wakeTiming, 0, sizeof(wakeTiming));
+    wakeTiming.budgetUs = DEFAULT_WAKE_BUDGET_US;
 }
 
 void SchedulingService::begin() {
+    beginUs = esp_timer_get_time();
     Serial.println("[SCHED] SchedulingService initialized");
+    loadWakeTiming();
+    configGeneration = configService.getGeneration();
+
+    bool restored = restoreSleepState();
+    if (!restored) {
+        compileSchedules(clockService.now().unixtime());
+    }
+
+    if (!clockService.isAvailable() || !clockService.isTimeTrusted()) {
+        Serial.println("[SCHED] Clock not available/trusted - skipping event generation");
+        hasNextEvent = false;
+        programNextAlarms();
+        return;
+    }
 
-    // Generate initial timer events from config
-    generateTimerEvents();
+    uint32_t now = clockService.now(true).unixtime();
 
-    // Program first alarm
-    programNextAlarm();
+    // Seek including the grace window, so an alarm that woke us just now is
+    // still picked up and executed right here. A restored cursor is reused
+    // unless we slept past it (e.g. a button wake days later), in which case
+    // the missed feeds are skipped rather than replayed.
+    if (!restored || !hasNextEvent || nextEvent.timestamp + GRACE_SECONDS < now) {
+        seekAfter(now - GRACE_SECONDS - 1);
+    }
+    dispatchDueEvents(now);
+    holdOnWake = holdActive && bootStartUs > 0;
+
+    // Program the first two wakes
+    programNextAlarms();
 }
 
 void SchedulingService::update() {
-    // Check if RTC alarm was triggered
+    // Check if RTC alarm was triggered (no I2C unless the INT line fired)
     if (clockService.checkAlarmFlag()) {
         Serial.println("[SCHED] RTC alarm triggered!");
         checkAlarm();
     }
+
+    if (holdActive) {
+        serviceHold();
+    }
+}
+
+uint8_t SchedulingService::getWakeLeadSeconds() const {
+    uint32_t lead = (wakeTiming.budgetUs + 999999) / 1000000;
+    return lead < MAX_WAKE_LEAD_SECONDS ? lead : MAX_WAKE_LEAD_SECONDS;
 }
 
 void SchedulingService::onConfigChanged() {
-    Serial.println("[SCHED] Configuration changed - regenerating timers");
+    uint32_t generation = configService.getGeneration();
+    if (generation == configGeneration) return;
+    configGeneration = generation;
+
+    // Other settings (e.g. the batch window) only need a fresh cursor
+    if (configService.getScheduleGeneration() != compiledGeneration) {
+        Serial.println("[SCHED] Configuration changed - recompiling schedules");
+        compileSchedules(clockService.now().unixtime());
+    }
 
-    // Regenerate all timer events
-    generateTimerEvents();
+    if (!clockService.isAvailable() || !clockService.isTimeTrusted()) {
+        Serial.println("[SCHED] Clock not available/trusted - skipping event generation");
+        hasNextEvent = false;
+    } else {
+        // Only strictly future occurrences - saving a schedule for the current
+        // minute must not trigger an immediate feed
+        uint32_t now = clockService.now().unixtime();
+        seekAfter(now);
+        // Too close for an alarm that leads by the wake budget
+        startHoldIfImminent(now);
+    }
 
-    // Program next alarm
-    programNextAlarm();
+    // Program next alarms
+    programNextAlarms();
 }
 
 void SchedulingService::checkAlarm() {
-    // Clear RTC alarm flag
-    clockService.clearAlarm();
+    // Clear the fired flag(s) and forget those channels - they are free to
+    // take the next wake. The other channel keeps its alarm armed.
+    uint8_t fired = clockService.getFiredAlarms();
+    for (uint8_t ch = 0; ch < ClockService::ALARM_COUNT; ch++) {
+        if (fired & (1 << ch)) {
+            clockService.acknowledgeAlarm(ch + 1);
+            armedAlarms[ch] = 0;
+        }
+    }
 
     // Find and handle all due events
-    TimerEvent *event = getNextDueEvent();
-    while (event != nullptr) {
-        handleTimerEvent(*event);
-        event->valid = false;  // Mark as done
-        event = getNextDueEvent();
+    // Fresh read: the cached time may still be in the second before the
+    // alarm, which would make the event look not due yet
+    if (hasNextEvent) {
+        dispatchDueEvents(clockService.now(true).unixtime());
     }
 
-    // Program next alarm
-    programNextAlarm();
+    // Refill the channel that fired
+    programNextAlarms();
 }
 
-void SchedulingService::generateTimerEvents() {
-    Serial.println("[SCHED] Generating timer events...");
-
-    // Clear existing events
-    timerEventCount = 0;
-    for (int i = 0; i < MAX_TIMER_EVENTS; i++) {
-        timerEvents[i].valid = false;
-    }
+void SchedulingService::compileSchedules(uint32_t at) {
+    // The week is compiled for the UTC offset in effect at `at`, and is only
+    // valid until the next DST transition
+    uint32_t from, until;
+    clockService.getUtcOffsetPeriod(at, from, until);
+    int32_t offset = clockService.getUtcOffsetAt(at);
+
+    weekFrom = from;
+    weekUntil = until;
+    // Clocks going back repeat an hour of local time; occurrences in it
+    // already ran in the previous period
+    int32_t repeated = from > 0 ? clockService.getUtcOffsetAt(from - 1) - offset : 0;
+    weekRepeatUntil = repeated > 0 ? from + repeated : 0;
+    compiledGeneration = configService.getScheduleGeneration();
+    weekSaved = false;
 
-    if (!clockService.isAvailable() || !clockService.isTimeTrusted()) {
-        Serial.println("[SCHED] Clock not available/trusted - skipping event generation");
-        return;
-    }
-
-    DateTime now = clockService.now();
-
-    // Load all schedules
     Schedule schedules[MAX_SCHEDULES];
     if (!configService.loadAllSchedules(schedules)) {
         Serial.println("[SCHED] Failed to load schedules");
+        week.clear();
         return;
     }
 
-    // Generate events for next 7 days for each enabled schedule
-    for (int schedIdx = 0; schedIdx < MAX_SCHEDULES; schedIdx++) {
-        Schedule &sched = schedules[schedIdx];
+    uint8_t overlaps = week.compile(schedules, offset / 60);
 
-        if (!sched.enabled) continue;
+    Serial.printf("[SCHED] Compiled %d feeding minutes per week (UTC%+d min)\n",
+                  week.slotCount, week.utcOffsetMinutes);
+    for (uint8_t i = 0; i < overlaps && i < MAX_WEEK_OVERLAPS; i++) {
+        const WeekOverlap &o = week.overlaps[i];
+        Serial.printf("[SCHED] Schedules %d and %d overlap at day %d %02d:%02d - merged\n",
+                      o.firstId, o.secondId, o.minuteOfWeek / MINUTES_PER_DAY,
+                      (o.minuteOfWeek % MINUTES_PER_DAY) / 60, o.minuteOfWeek % 60);
+    }
+}
 
-        // Try to find occurrences in next 7 days
-        DateTime checkTime = now;
-        for (int day = 0; day < 7 && timerEventCount < MAX_TIMER_EVENTS; day++) {
-            DateTime nextOccurrence = getNextOccurrence(sched, checkTime);
+void SchedulingService::seekAfter(uint32_t after) {
+    hasNextEvent = getNextOccurrence(after, nextEvent);
 
-            // Check if within next 7 days
-            if (nextOccurrence.isValid() && nextOccurrence.unixtime() <= (now.unixtime() + 7 * 24 * 60 * 60)) {
-                // Add to event list
-                timerEvents[timerEventCount].timestamp = nextOccurrence;
-                timerEvents[timerEventCount].scheduleId = sched.id;
-                timerEvents[timerEventCount].portionUnits = sched.portion_units;
-                timerEvents[timerEventCount].valid = true;
-                timerEventCount++;
+    if (hasNextEvent) {
+        DateTime dt(clockService.toLocal(nextEvent.timestamp));
+        Serial.printf("[SCHED] Next event: Schedule %d at %04d-%02d-%02d %02d:%02d\n",
+                      nextEvent.scheduleId, dt.year(), dt.month(), dt.day(), dt.hour(), dt.minute());
+    }
+}
 
-                Serial.printf("[SCHED] Added event: Schedule %d at %04d-%02d-%02d %02d:%02d\n",
-                              sched.id,
-                              nextOccurrence.year(), nextOccurrence.month(), nextOccurrence.day(),
-                              nextOccurrence.hour(), nextOccurrence.minute());
+void SchedulingService::dispatchDueEvents(uint32_t now) {
+    while (hasNextEvent && nextEvent.timestamp <= now) {
+        TimerEvent batch = nextEvent;
+        uint8_t merged = collectBatch(batch, nextEvent, hasNextEvent);
 
-                // Move to next day
-                checkTime = DateTime(nextOccurrence.unixtime() + 24 * 60 * 60);
-            } else {
-                break;
-            }
+        if (merged > 1) {
+            Serial.printf("[SCHED] Batched %d events within %d min into one feed\n",
+                          merged, configService.getBatchWindowMinutes());
         }
+        handleTimerEvent(batch);
     }
 
-    Serial.printf("[SCHED] Generated %d timer events\n", timerEventCount);
+    startHoldIfImminent(now);
 }
 
-DateTime SchedulingService::getNextOccurrence(const Schedule &schedule, const DateTime &from) {
-    // Parse time from schedule (format: "HH:MM")
-    int hour = (schedule.time[0] - '0') * 10 + (schedule.time[1] - '0');
-    int minute = (schedule.time[3] - '0') * 10 + (schedule.time[4] - '0');
+void SchedulingService::startHoldIfImminent(uint32_t now) {
+    if (holdActive || !hasNextEvent || nextEvent.timestamp > now + HOLD_HORIZON_SECONDS) return;
 
-    // Start from today at the scheduled time
-    DateTime candidate(from.year(), from.month(), from.day(), hour, minute, 0);
+    // Commit the batch now: the cursor moves on, so the alarms go to the
+    // wakes after it rather than to one whose alarm time has passed
+    heldBatch = nextEvent;
+    uint8_t merged = collectBatch(heldBatch, nextEvent, hasNextEvent);
+    holdActive = true;
+    holdWarming = false;
+    holdOnWake = false;
+    loopStartUs = 0;
+
+    Serial.printf("[SCHED] Holding %d event(s) for %lu s until the target second\n",
+                  merged, (unsigned long)(heldBatch.timestamp - now));
+}
 
-    // Allow a small grace window so alarms that just fired are still considered "due"
-    const uint32_t GRACE_SECONDS = 60;
-    if (candidate.unixtime() < (from.unixtime() - GRACE_SECONDS)) {
-        // Time is more than the grace window in the past, move to tomorrow
-        candidate = DateTime(candidate.unixtime() + 24 * 60 * 60);
+void SchedulingService::serviceHold() {
+    const int64_t nowUs = esp_timer_get_time();
+    if (loopStartUs == 0) loopStartUs = nowUs;
+
+    if (!holdWarming) {
+        // Whole seconds that may be almost a second stale - start one
+        // second early rather than late
+        uint32_t now = clockService.now().unixtime();
+        uint32_t warmupLead = (wakeTiming.warmupUs + WAKE_BUDGET_MARGIN_US) / 1000000 + 1;
+        if (now + warmupLead < heldBatch.timestamp) return;
+
+        if (feedingService.isFeeding()) {
+            // A manual feed is still running: no exact start, but the
+            // queue runs it right after, ahead of anything else waiting
+            Serial.printf("[SCHED] Executing timer event: Schedule %d, %d portions (queued, feeder busy)\n",
+                          heldBatch.scheduleId, heldBatch.portionUnits);
+            feedingService.feed(heldBatch.portionUnits, FEED_SOURCE_SCHEDULE, false, heldBatch.scheduleId);
+            holdActive = false;
+            return;
+        }
+
+        Serial.printf("[SCHED] Executing timer event: Schedule %d, %d portions (held)\n",
+                      heldBatch.scheduleId, heldBatch.portionUnits);
+        feedingService.feed(heldBatch.portionUnits, FEED_SOURCE_SCHEDULE, true, heldBatch.scheduleId);
+        holdWarming = true;
+        warmStartUs = nowUs;
+        readyUs = 0;
+        return;
+    }
+
+    if (!feedingService.isHolding()) {
+        // Warm-up aborted (servo attach failed) - nothing to open
+        holdActive = false;
+        return;
     }
+    if (!feedingService.isReadyToOpen()) return;
+    if (readyUs == 0) readyUs = nowUs;
+
+    uint32_t now = clockService.now().unixtime();
+    if (now + 1 < heldBatch.timestamp) return;
+
+    // Block through the last second and open on the RTC's tick
+    int64_t tickUs;
+    bool onTime = clockService.waitForSecond(heldBatch.timestamp, tickUs);
+    feedingService.release();
+    int64_t releaseUs = esp_timer_get_time();
+
+    // Late: the tick was missed, so only whole seconds are known
+    int32_t latenessMs = onTime ? (int32_t)((releaseUs - tickUs) / 1000)
+                                : ((int32_t)clockService.now(true).unixtime() - (int32_t)heldBatch.timestamp) * 1000;
+    finishHold(latenessMs, releaseUs);
+}
 
-    // Find next day that matches weekday mask (max 7 days forward)
-    for (int i = 0; i < 7; i++) {
-        uint8_t weekday = candidate.dayOfTheWeek();  // 0=Sunday, 6=Saturday
+void SchedulingService::finishHold(int32_t latenessMs, int64_t releaseUs) {
+    holdActive = false;
+    const uint8_t lead = getWakeLeadSeconds();
 
-        if (isActiveOnWeekday(schedule.weekday_mask, weekday)) {
-            return candidate;
+    wakeTiming.warmupUs = (uint32_t)(readyUs - warmStartUs);
+    wakeTiming.holdUs = (uint32_t)(releaseUs - readyUs);
+    wakeTiming.latenessMs = latenessMs;
+    if (wakeTiming.feeds == 0 || latenessMs > wakeTiming.maxLatenessMs) {
+        wakeTiming.maxLatenessMs = latenessMs;
+    }
+    wakeTiming.feeds++;
+
+    if (holdOnWake) {
+        // esp_timer starts at the wake-up reset. The warm-up may have been
+        // put off (an alarm far ahead), so the need is the first chance to
+        // start it plus how long it took.
+        wakeTiming.bootUs = (uint32_t)bootStartUs;
+        wakeTiming.setupUs = (uint32_t)(beginUs - bootStartUs);
+        wakeTiming.initUs = (uint32_t)(loopStartUs - beginUs);
+
+        uint32_t need = (uint32_t)loopStartUs + wakeTiming.warmupUs + WAKE_BUDGET_MARGIN_US;
+        if (need > wakeTiming.budgetUs) {
+            wakeTiming.budgetUs = need;
+        } else {
+            wakeTiming.budgetUs -= (wakeTiming.budgetUs - need) / WAKE_BUDGET_DECAY;
         }
+    }
+    saveWakeTiming();
+
+    Serial.printf("[SCHED] Hopper opened %ld ms after the target second (wake budget %lu ms)\n",
+                  (long)latenessMs, (unsigned long)(wakeTiming.budgetUs / 1000));
 
-        // Move to next day
-        candidate = DateTime(candidate.unixtime() + 24 * 60 * 60);
+    if (getWakeLeadSeconds() != lead) {
+        // The armed alarms still lead by the old budget
+        programNextAlarms();
     }
+}
 
-    // No valid occurrence found
-    return DateTime((uint32_t)0);
+void SchedulingService::loadWakeTiming() {
+    if (wakeTimingState.magic == WAKE_TIMING_MAGIC && wakeTimingState.crc == wakeTimingCrc(wakeTimingState)) {
+        wakeTiming = wakeTimingState.timing;
+    }
 }
 
-bool SchedulingService::isActiveOnWeekday(uint8_t weekdayMask, uint8_t weekday) {
-    // weekday: 0=Sunday, 1=Monday, ..., 6=Saturday
-    // weekdayMask: bit 0=Sunday, bit 1=Monday, ..., bit 6=Saturday
-    return (weekdayMask & (1 << weekday)) != 0;
+void SchedulingService::saveWakeTiming() {
+    wakeTimingState.magic = WAKE_TIMING_MAGIC;
+    wakeTimingState.timing = wakeTiming;
+    wakeTimingState.crc = wakeTimingCrc(wakeTimingState);
 }
 
-TimerEvent* SchedulingService::getNextFutureEvent() {
-    DateTime now = clockService.now();
-    TimerEvent *best = nullptr;
+uint8_t SchedulingService::collectBatch(TimerEvent &batch, TimerEvent &after, bool &hasAfter) {
+    // Pull every later event inside the batching window into this wake,
+    // so nearby schedules cost one boot and one feed sequence instead of
+    // one each. Stop before the merged feed would exceed what feed() can
+    // dispense in one go - the rest keeps its own alarm.
+    const uint32_t window = (uint32_t)configService.getBatchWindowMinutes() * 60;
+    const uint32_t batchEnd = batch.timestamp + window;
+    uint8_t merged = 1;
+
+    hasAfter = getNextOccurrence(batch.timestamp, after);
+    while (window > 0 && hasAfter && after.timestamp <= batchEnd &&
+           batch.portionUnits + after.portionUnits <= 10) {
+        batch.portionUnits += after.portionUnits;
+        // Several schedules in one feed: no single id for the history
+        if (after.scheduleId != batch.scheduleId) batch.scheduleId = 0;
+        merged++;
+        hasAfter = getNextOccurrence(after.timestamp, after);
+    }
 
-    for (int i = 0; i < MAX_TIMER_EVENTS; i++) {
-        if (!timerEvents[i].valid) continue;
-        if (timerEvents[i].timestamp.unixtime() <= now.unixtime()) continue;
+    return merged;
+}
 
-        if (best == nullptr || timerEvents[i].timestamp.unixtime() < best->timestamp.unixtime()) {
-            best = &timerEvents[i];
+bool SchedulingService::getNextOccurrence(uint32_t after, TimerEvent &event) {
+    // Plain UTC minute math inside one offset period; crossing a DST
+    // transition recompiles the week for the next period and continues
+    // from there. A handful of steps covers any realistic rule.
+    for (uint8_t step = 0; step < 4; step++) {
+        if (after + 1 < weekFrom || (weekUntil != 0 && after + 1 >= weekUntil)) {
+            compileSchedules(after + 1);
+        }
+
+        // First whole minute starting strictly after `after`
+        uint32_t minute = after / 60 + 1;
+
+        int32_t delta = week.minutesUntilNext(WeekSchedule::minuteOfWeek(minute * 60));
+        if (delta < 0) return false;
+
+        uint32_t timestamp = (minute + delta) * 60;
+        if (weekUntil != 0 && timestamp >= weekUntil) {
+            after = weekUntil - 1;
+            continue;
+        }
+        if (timestamp < weekRepeatUntil) {
+            after = weekRepeatUntil - 1;
+            continue;
         }
+
+        event.timestamp = timestamp;
+        const WeekSlot *slot = week.slotAt(WeekSchedule::minuteOfWeek(timestamp));
+        event.scheduleId = slot ? slot->scheduleId : 0;
+        event.portionUnits = slot ? slot->portionUnits : 1;
+        return true;
     }
 
-    return best;
+    return false;
 }
 
-TimerEvent* SchedulingService::getNextDueEvent() {
-    DateTime now = clockService.now();
-    TimerEvent *best = nullptr;
+void SchedulingService::programNextAlarms() {
+    // The next two wakes: the cursor, and the first event its batch does
+    // not swallow. 0 = nothing to arm.
+    uint32_t wakes[ClockService::ALARM_COUNT] = {0, 0};
+    if (hasNextEvent) {
+        TimerEvent batch = nextEvent;
+        TimerEvent following;
+        bool hasFollowing;
+        collectBatch(batch, following, hasFollowing);
+
+        wakes[0] = nextEvent.timestamp;
+        if (hasFollowing) wakes[1] = following.timestamp;
+    } else {
+        Serial.println("[SCHED] No future events - alarms disabled");
+    }
+
+    // Channels still holding one of the wakes stay untouched; anything else
+    // is stale and gets disabled. Alarms lead the feed by the wake budget,
+    // which Alarm 2 can only round down to the minute. That earlier time
+    // still holds the wake - the hold waits for the target second - so
+    // only the channel that fired is written again.
+    const uint8_t lead = getWakeLeadSeconds();
+    int8_t channelOf[ClockService::ALARM_COUNT] = {-1, -1};
+    for (uint8_t w = 0; w < ClockService::ALARM_COUNT; w++) {
+        for (uint8_t ch = 0; ch < ClockService::ALARM_COUNT; ch++) {
+            uint32_t alarmTime = wakes[w] != 0 ? alarmTimeFor(ch, wakes[w]) : 0;
+            if (wakes[w] != 0 && armedAlarms[ch] == alarmTime && holdsWake(alarmTime, wakes[w])) {
+                channelOf[w] = ch;
+            }
+        }
+    }
 
-    for (int i = 0; i < MAX_TIMER_EVENTS; i++) {
-        if (!timerEvents[i].valid) continue;
-        if (timerEvents[i].timestamp.unixtime() > now.unixtime()) continue;
+    // The nearer wake is placed first: on a free channel that hits the
+    // lead exactly, else on the one holding the later wake - better lose
+    // the wake after than wake a minute early - and only then anywhere.
+    bool failed[ClockService::ALARM_COUNT] = {false, false};
+    for (uint8_t w = 0; w < ClockService::ALARM_COUNT; w++) {
+        if (wakes[w] == 0 || channelOf[w] >= 0) continue;
+
+        for (uint8_t pass = 0; pass < 4 && channelOf[w] < 0; pass++) {
+            const bool exactOnly = pass < 2;
+            const bool displace = pass % 2 == 1;
+            if (displace && w != 0) continue;
+
+            for (uint8_t ch = 0; ch < ClockService::ALARM_COUNT && channelOf[w] < 0; ch++) {
+                bool taken = channelOf[1 - w] == ch;
+                uint32_t alarmTime = alarmTimeFor(ch, wakes[w]);
+                if (failed[ch] || taken != displace || (exactOnly && alarmTime != wakes[w] - lead)) continue;
+
+                if (clockService.setAlarm(ch + 1, DateTime(alarmTime))) {
+                    armedAlarms[ch] = alarmTime;
+                    channelOf[w] = ch;
+                    if (taken) channelOf[1 - w] = -1;
+                    Serial.printf("[SCHED] Alarm %d programmed for %s wake\n",
+                                  ch + 1, w == 0 ? "next" : "following");
+                } else {
+                    armedAlarms[ch] = 0;
+                    failed[ch] = true;
+                }
+            }
+        }
+    }
 
-        if (best == nullptr || timerEvents[i].timestamp.unixtime() < best->timestamp.unixtime()) {
-            best = &timerEvents[i];
+    for (uint8_t ch = 0; ch < ClockService::ALARM_COUNT; ch++) {
+        if (channelOf[0] != ch && channelOf[1] != ch && !failed[ch]) {
+            // Also covers channels in an unknown state after a cold boot
+            clockService.clearAlarm(ch + 1);
+            armedAlarms[ch] = 0;
         }
     }
 
-    return best;
+    if (wakes[0] != 0 && channelOf[0] < 0) {
+        Serial.println("[SCHED] Could not arm any RTC alarm for the next feed");
+    }
+
+    saveSleepState();
 }
 
-void SchedulingService::programNextAlarm() {
-    TimerEvent *next = getNextFutureEvent();
+uint32_t SchedulingService::alarmTimeFor(uint8_t ch, uint32_t wake) const {
+    uint32_t early = wake - getWakeLeadSeconds();
+    return ch == 0 ? early : early - early % 60;
+}
 
-    if (next == nullptr) {
-        Serial.println("[SCHED] No future events - alarm disabled");
-        clockService.clearAlarm();
-        return;
+bool SchedulingService::holdsWake(uint32_t alarmTime, uint32_t wake) const {
+    return alarmTime <= wake - getWakeLeadSeconds() && wake - alarmTime <= HOLD_HORIZON_SECONDS;
+}
+
+bool SchedulingService::restoreSleepState() {
+    if (sleepState.magic != SLEEP_STATE_MAGIC || sleepState.crc != sleepStateCrc(sleepState) ||
+        sleepState.weekCrc != weekCrc(sleepState.week)) {
+        Serial.println("[SCHED] No scheduler state in RTC memory");
+        return false;
     }
 
-    // Program RTC alarm for next event
-    if (clockService.setAlarm(next->timestamp)) {
-        Serial.printf("[SCHED] Next alarm programmed for schedule %d\n", next->scheduleId);
+    if (sleepState.configGeneration != configService.getScheduleGeneration()) {
+        Serial.println("[SCHED] Schedules changed since last sleep - recompiling");
+        return false;
+    }
+
+    week = sleepState.week;
+    weekSaved = true;
+    compiledGeneration = sleepState.configGeneration;
+    weekFrom = sleepState.weekFrom;
+    weekUntil = sleepState.weekUntil;
+    weekRepeatUntil = sleepState.weekRepeatUntil;
+    nextEvent = sleepState.nextEvent;
+    hasNextEvent = sleepState.hasNextEvent;
+    memcpy(armedAlarms, sleepState.armedAlarms, sizeof(armedAlarms));
+
+    Serial.printf("[SCHED] Restored %d feeding minutes from RTC memory\n", week.slotCount);
+    return true;
+}
+
+void SchedulingService::saveSleepState() {
+    sleepState.magic = SLEEP_STATE_MAGIC;
+    sleepState.configGeneration = compiledGeneration;
+    // Called on every alarm refill; the week only changes on a recompile
+    if (!weekSaved) {
+        sleepState.week = week;
+        sleepState.weekCrc = weekCrc(week);
+        weekSaved = true;
     }
+    sleepState.weekFrom = weekFrom;
+    sleepState.weekUntil = weekUntil;
+    sleepState.weekRepeatUntil = weekRepeatUntil;
+    sleepState.nextEvent = nextEvent;
+    sleepState.hasNextEvent = hasNextEvent;
+    memcpy(sleepState.armedAlarms, armedAlarms, sizeof(armedAlarms));
+    sleepState.crc = sleepStateCrc(sleepState);
 }
 
-void SchedulingService::handleTimerEvent(TimerEvent &event) {
+void SchedulingService::handleTimerEvent(const TimerEvent &event) {
     Serial.printf("[SCHED] Executing timer event: Schedule %d, %d portions\n",
                   event.scheduleId, event.portionUnits);
 
-    // Trigger feeding
-    feedingService.feed(event.portionUnits);
+    // Trigger feeding; queued if a manual feed is still running
+    feedingService.feed(event.portionUnits, FEED_SOURCE_SCHEDULE, false, event.scheduleId);
 }
@@ -6,14 +6,27 @@
 #include "ConfigService.hpp"
 #include "ClockService.hpp"
 #include "FeedingService.hpp"
-
-#define MAX_TIMER_EVENTS 50  // Max events in queue (e.g., week of schedules)
+#include "WeekSchedule.hpp"
 
 struct TimerEvent {
-    DateTime timestamp;
-    uint8_t scheduleId;  // Which schedule triggered this
+    uint32_t timestamp;     // Unix time of the occurrence (UTC, like the RTC)
+    uint8_t scheduleId;     // Which schedule triggered this; 0 for a batch of several
     uint8_t portionUnits;
-    bool valid;
+};
+
+// Where the time goes between a scheduled wake and the hopper opening. The
+// scheduler arms its alarms early by budgetUs and holds the warmed-up
+// servos until the target second; the budget follows the measured need.
+struct WakeTiming {
+    uint32_t bootUs;      // Wake-up reset until setup() (ROM, bootloader, app init)
+    uint32_t setupUs;     // setup() until SchedulingService::begin()
+    uint32_t initUs;      // begin() until the servo warm-up started
+    uint32_t warmupUs;    // Servo power-on until ready to open
+    uint32_t holdUs;      // Ready to open until the target second
+    int32_t latenessMs;   // Hopper opening after the target second, last held feed
+    int32_t maxLatenessMs;
+    uint32_t budgetUs;    // Self-calibrated wake-to-ready budget
+    uint32_t feeds;       // Held feeds measured
 };
 
 class SchedulingService {
@@ -23,40 +36,112 @@ public:
     void begin();
     void update();
 
-    // Called when configuration changes
+    // esp_timer time setup() started at, on a wake from an RTC alarm. Lets
+    // begin() attribute the boot time for the wake budget.
+    void setBootStart(int64_t setupStartUs) { bootStartUs = setupStartUs; }
+
+    // A feed is waiting for its target second (keep the device awake)
+    bool isHoldingFeed() const { return holdActive; }
+    const WakeTiming& getWakeTiming() const { return wakeTiming; }
+    // Alarms fire this many seconds before a scheduled feed
+    uint8_t getWakeLeadSeconds() const;
+
+    // Called when configuration may have changed; a no-op unless the
+    // config generation moved, recompiling only if the schedules did
     void onConfigChanged();
 
     // Check for alarm trigger (call from loop or ISR flag)
     void checkAlarm();
 
+    // Schedules claiming the same minute (merged into one feed)
+    uint8_t getOverlapCount() const { return week.overlapCount; }
+    const WeekOverlap* getOverlaps() const { return week.overlaps; }
+
 private:
     ConfigService &configService;
     ClockService &clockService;
     FeedingService &feedingService;
 
-    TimerEvent timerEvents[MAX_TIMER_EVENTS];
-    int timerEventCount;
-
-    // Calculate next week of timer events from schedules
-    void generateTimerEvents();
-
-    // Find next future event
-    TimerEvent* getNextFutureEvent();
-
-    // Find next due event (now or past)
-    TimerEvent* getNextDueEvent();
-
-    // Program the next alarm on RTC
-    void programNextAlarm();
+    // Enabled schedules compiled into one bit per minute of the week. This
+    // is already the merged stream of all schedules, so the next event is a
+    // find-next-set-bit scan from the cursor. Bits are UTC minutes for the
+    // offset in effect during [weekFrom, weekUntil) - the span between two
+    // DST transitions (0 = open end).
+    WeekSchedule week;
+    uint32_t weekFrom;
+    uint32_t weekUntil;
+    uint32_t weekRepeatUntil;  // End of the repeated local hour after clocks go back
+    TimerEvent nextEvent;
+    bool hasNextEvent;
+    // ConfigService generation last acted on, and the schedule generation
+    // the week was compiled from
+    uint32_t configGeneration;
+    uint32_t compiledGeneration;
+    bool weekSaved;  // The RTC memory snapshot holds this week
+    // Alarm time armed on each DS3231 alarm channel, 0 = none/unknown. The
+    // next two wakes are kept armed, so each alarm only refills its own
+    // channel while the other one is already waiting.
+    uint32_t armedAlarms[ClockService::ALARM_COUNT];
+
+    // Feed whose alarm fired early, waiting for its target second. The
+    // cursor has already moved past it.
+    bool holdActive;
+    bool holdWarming;
+    bool holdOnWake;  // Started by begin() on an alarm wake - measures the boot
+    TimerEvent heldBatch;
+    int64_t bootStartUs;
+    int64_t beginUs;
+    int64_t loopStartUs;  // First serviceHold() call
+    int64_t warmStartUs;
+    int64_t readyUs;
+    WakeTiming wakeTiming;
+
+    // Load schedules and compile them into the week bitmap for the UTC
+    // offset in effect at `at`
+    void compileSchedules(uint32_t at);
+
+    // Keep week, cursor and armed alarms in RTC slow memory so an alarm wake
+    // can skip loading and compiling the schedules
+    bool restoreSleepState();
+    void saveSleepState();
+
+    // Point the cursor at the first occurrence strictly after `after`
+    void seekAfter(uint32_t after);
+
+    // Execute all events due at `now`, advancing the cursor
+    void dispatchDueEvents(uint32_t now);
+
+    // Merge the events inside the batching window into `batch` (which holds
+    // the first one). `after` receives the first event left out. Returns the
+    // number of events merged.
+    uint8_t collectBatch(TimerEvent &batch, TimerEvent &after, bool &hasAfter);
+
+    // Keep the next two wakes armed on the RTC's two alarm channels
+    void programNextAlarms();
+
+    // Alarm time for a wake on channel `ch` (0-based): early by the wake
+    // lead, rounded down to the minute on Alarm 2
+    uint32_t alarmTimeFor(uint8_t ch, uint32_t wake) const;
+    // An alarm no later than the lead and close enough for the hold to
+    // take the wake when it fires
+    bool holdsWake(uint32_t alarmTime, uint32_t wake) const;
+
+    // Take the next batch into the hold if it is close enough
+    void startHoldIfImminent(uint32_t now);
+    // Warm up, wait for the target second, open; called from update()
+    void serviceHold();
+    void finishHold(int32_t latenessMs, int64_t releaseUs);
+
+    // Wake timing lives in RTC memory, apart from the schedule state, so
+    // schedule edits don't reset the calibration
+    void loadWakeTiming();
+    void saveWakeTiming();
 
     // Handle a triggered timer event
-    void handleTimerEvent(TimerEvent &event);
-
-    // Calculate next occurrence of a schedule
-    DateTime getNextOccurrence(const Schedule &schedule, const DateTime &from);
+    void handleTimerEvent(const TimerEvent &event);
 
-    // Check if schedule should run on given weekday
-    bool isActiveOnWeekday(uint8_t weekdayMask, uint8_t weekday);
+    // First scheduled occurrence strictly after `after`, false if none
+    bool getNextOccurrence(uint32_t after, TimerEvent &event);
 };
 
 #endif // SCHEDULING_SERVICE_HPP
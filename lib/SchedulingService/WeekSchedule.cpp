@@ -0,0 +1,106 @@
+#include "WeekSchedule.hpp"
+
+void WeekSchedule::clear() {
+    memset(this, 0, sizeof(*this));
+}
+
+uint8_t WeekSchedule::compile(const Schedule schedules[MAX_SCHEDULES], int16_t offsetMinutes) {
+    clear();
+    utcOffsetMinutes = offsetMinutes;
+
+    // Shift that moves a local minute of the week to UTC, kept non-negative
+    uint16_t toUtc = ((int32_t)MINUTES_PER_WEEK - offsetMinutes % MINUTES_PER_WEEK) % MINUTES_PER_WEEK;
+
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        const Schedule &sched = schedules[i];
+        if (!sched.enabled || sched.weekday_mask == 0) continue;
+
+        uint16_t minuteOfDay;
+        if (!parseScheduleTime(sched.time, minuteOfDay)) continue;
+
+        for (uint8_t weekday = 0; weekday < 7; weekday++) {
+            if ((sched.weekday_mask & (1 << weekday)) == 0) continue;
+
+            uint16_t localMow = weekday * MINUTES_PER_DAY + minuteOfDay;
+            uint16_t mow = (localMow + toUtc) % MINUTES_PER_WEEK;
+            uint32_t bit = 1UL << (mow & 31);
+
+            if (bits[mow >> 5] & bit) {
+                // Minute already claimed by an earlier schedule - merge into it
+                for (uint8_t s = 0; s < slotCount; s++) {
+                    if (slots[s].minuteOfWeek != mow) continue;
+
+                    if (overlapCount < MAX_WEEK_OVERLAPS) {
+                        overlaps[overlapCount] = {localMow, slots[s].scheduleId, sched.id};
+                    }
+                    if (overlapCount < 255) overlapCount++;
+
+                    uint16_t sum = slots[s].portionUnits + sched.portion_units;
+                    slots[s].portionUnits = sum > 10 ? 10 : sum;
+                    break;
+                }
+                continue;
+            }
+
+            bits[mow >> 5] |= bit;
+
+            // Insertion keeps slots sorted (at most 42 entries)
+            uint8_t pos = slotCount;
+            while (pos > 0 && slots[pos - 1].minuteOfWeek > mow) {
+                slots[pos] = slots[pos - 1];
+                pos--;
+            }
+            slots[pos] = {mow, sched.id, sched.portion_units};
+            slotCount++;
+        }
+    }
+
+    return overlapCount;
+}
+
+bool WeekSchedule::isDue(uint16_t minuteOfWeek) const {
+    if (minuteOfWeek >= MINUTES_PER_WEEK) return false;
+    return (bits[minuteOfWeek >> 5] >> (minuteOfWeek & 31)) & 1;
+}
+
+int32_t WeekSchedule::minutesUntilNext(uint16_t minuteOfWeek) const {
+    if (slotCount == 0 || minuteOfWeek >= MINUTES_PER_WEEK) return -1;
+
+    uint16_t word = minuteOfWeek >> 5;
+    uint32_t masked = bits[word] & (~0UL << (minuteOfWeek & 31));
+
+    // Walk forward one word at a time, wrapping once around the week; the
+    // start word is visited a second time unmasked to catch earlier bits
+    for (uint16_t step = 0; step <= WEEK_BITMAP_WORDS; step++) {
+        if (masked != 0) {
+            uint32_t found = ((uint32_t)word << 5) + __builtin_ctzl(masked);
+            return (found + MINUTES_PER_WEEK - minuteOfWeek) % MINUTES_PER_WEEK;
+        }
+        word = (word + 1) % WEEK_BITMAP_WORDS;
+        masked = bits[word];
+    }
+
+    return -1;
+}
+
+const WeekSlot* WeekSchedule::slotAt(uint16_t minuteOfWeek) const {
+    if (!isDue(minuteOfWeek)) return nullptr;
+
+    uint8_t lo = 0;
+    uint8_t hi = slotCount;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (slots[mid].minuteOfWeek < minuteOfWeek) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return (lo < slotCount && slots[lo].minuteOfWeek == minuteOfWeek) ? &slots[lo] : nullptr;
+}
+
+uint16_t WeekSchedule::minuteOfWeek(uint32_t unixTime) {
+    // Shift by four days so that minute 0 is a Sunday
+    return (unixTime / 60 + 4UL * MINUTES_PER_DAY) % MINUTES_PER_WEEK;
+}
@@ -0,0 +1,62 @@
+#ifndef WEEK_SCHEDULE_HPP
+#define WEEK_SCHEDULE_HPP
+
+#include <Arduino.h>
+#include "ConfigService.hpp"
+
+#define MINUTES_PER_DAY 1440
+#define MINUTES_PER_WEEK 10080
+#define WEEK_BITMAP_WORDS (MINUTES_PER_WEEK / 32)  // 315 words = 1260 bytes
+#define MAX_WEEK_SLOTS (MAX_SCHEDULES * 7)
+#define MAX_WEEK_OVERLAPS 8
+
+// One feeding minute of the week. minuteOfWeek 0 = Sunday 00:00, matching
+// DateTime::dayOfTheWeek() and the Schedule weekday_mask bit order. Bits
+// and slots are in UTC (local schedule time minus the compile offset).
+struct WeekSlot {
+    uint16_t minuteOfWeek;
+    uint8_t scheduleId;    // First schedule claiming this minute
+    uint8_t portionUnits;  // Sum over all schedules claiming it (max 10)
+};
+
+// A minute claimed by more than one enabled schedule (local minute of week)
+struct WeekOverlap {
+    uint16_t minuteOfWeek;
+    uint8_t firstId;
+    uint8_t secondId;
+};
+
+// All enabled schedules compiled into a single bit per minute of the week.
+// Plain data on purpose - it can be copied around (and kept across deep
+// sleep) as one block.
+struct WeekSchedule {
+    uint32_t bits[WEEK_BITMAP_WORDS];
+    WeekSlot slots[MAX_WEEK_SLOTS];  // Sorted by minuteOfWeek
+    uint8_t slotCount;
+    uint8_t overlapCount;            // Total overlaps, may exceed MAX_WEEK_OVERLAPS
+    WeekOverlap overlaps[MAX_WEEK_OVERLAPS];
+    int16_t utcOffsetMinutes;        // Local time offset the week was compiled for
+
+    void clear();
+
+    // Rebuild from the schedule table (local times) for a fixed UTC offset;
+    // returns the number of overlaps found
+    uint8_t compile(const Schedule schedules[MAX_SCHEDULES], int16_t utcOffsetMinutes = 0);
+
+    bool isEmpty() const { return slotCount == 0; }
+
+    // O(1): is any schedule set for this minute of the week?
+    bool isDue(uint16_t minuteOfWeek) const;
+
+    // Minutes from `minuteOfWeek` (inclusive) to the next set minute, wrapping
+    // around the week; -1 if nothing is scheduled at all
+    int32_t minutesUntilNext(uint16_t minuteOfWeek) const;
+
+    // Slot for a set minute, nullptr if the minute is not scheduled
+    const WeekSlot* slotAt(uint16_t minuteOfWeek) const;
+
+    // Minute of the week for a unix timestamp (1970-01-01 was a Thursday)
+    static uint16_t minuteOfWeek(uint32_t unixTime);
+};
+
+#endif // WEEK_SCHEDULE_HPP
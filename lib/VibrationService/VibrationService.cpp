@@ -1,7 +1,10 @@
 #include "VibrationService.hpp"
 
+static const char* const PATTERN_NAMES[VIBRATION_PATTERN_COUNT] = {"steady", "pulses", "ramp"};
+
 VibrationService::VibrationService() {
 #if VIBRATION_MOTOR_ENABLED
+  // Held low until the first shake attaches LEDC
   pinMode(VIBRATION_PIN, OUTPUT);
   digitalWrite(VIBRATION_PIN, LOW);
 
@@ -13,21 +16,80 @@ VibrationService::VibrationService() {
 
 void VibrationService::setPin(bool on) {
 #if VIBRATION_MOTOR_ENABLED
+  if (on && !pinOn) {
+    // Soft start from standstill only; a pattern change keeps running
+    startedAtMillis = millis();
+  }
   pinOn = on;
-  digitalWrite(VIBRATION_PIN, on ? HIGH : LOW);
+  writeDuty(on ? dutyAt(millis()) : 0);
 #endif
 }
 
+void VibrationService::writeDuty(uint32_t value) {
+#if VIBRATION_MOTOR_ENABLED
+  if (value == duty && pwmAttached) return;
+
+  if (!pwmAttached) {
+    // Attached on first use, LEDC isn't set up yet when globals are constructed
+    if (!ledcAttach(VIBRATION_PIN, VIBRATION_PWM_FREQUENCY, VIBRATION_PWM_RESOLUTION)) {
+      digitalWrite(VIBRATION_PIN, value > 0 ? HIGH : LOW);
+      duty = value > 0 ? VIBRATION_MAX_DUTY : 0;
+      return;
+    }
+    pwmAttached = true;
+  }
+  ledcWrite(VIBRATION_PIN, value);
+  duty = value;
+#endif
+}
+
+uint32_t VibrationService::dutyAt(unsigned long now) const {
+  uint32_t level = VIBRATION_MAX_DUTY;
+  unsigned long running = now - startedAtMillis;
+
+  switch (pattern) {
+    case VIBRATION_STEADY:
+      break;
+
+    case VIBRATION_PULSES:
+      if (running % (VIBRATION_PULSE_ON_MS + VIBRATION_PULSE_OFF_MS) >= VIBRATION_PULSE_ON_MS) {
+        return 0;
+      }
+      break;
+
+    case VIBRATION_RAMP: {
+      // Triangle between VIBRATION_RAMP_MIN_PERCENT and full, starting low
+      uint32_t phase = running % VIBRATION_RAMP_PERIOD_MS;
+      uint32_t half = VIBRATION_RAMP_PERIOD_MS / 2;
+      uint32_t rise = phase < half ? phase : VIBRATION_RAMP_PERIOD_MS - phase;
+      uint32_t low = VIBRATION_MAX_DUTY * VIBRATION_RAMP_MIN_PERCENT / 100;
+      level = low + (VIBRATION_MAX_DUTY - low) * rise / half;
+      break;
+    }
+  }
+
+  if (running < VIBRATION_SOFT_START_MS) {
+    level = level * running / VIBRATION_SOFT_START_MS;
+  }
+  return level;
+}
+
 void VibrationService::update() {
-  if (pinOn && !feedShakeForced && millis() >= offAtMillis) {
+  if (!pinOn) return;
+
+  unsigned long now = millis();
+  if (!feedShakeForced && now >= offAtMillis) {
     setPin(false);
+    return;
   }
+  writeDuty(dutyAt(now));
 }
 
-void VibrationService::startFeedShake() {
+void VibrationService::startFeedShake(VibrationPattern shakePattern) {
   feedShakeForced = true;
+  pattern = shakePattern < VIBRATION_PATTERN_COUNT ? shakePattern : VIBRATION_STEADY;
   setPin(true);
-  Serial.println("[VIBRATION] Feed shake started");
+  Serial.printf("[VIBRATION] Feed shake started (%s)\n", PATTERN_NAMES[pattern]);
 }
 
 void VibrationService::endFeedShake(uint32_t tailMs) {
@@ -49,6 +111,7 @@ void VibrationService::triggerPulse(uint32_t durationMs) {
     return;
   }
 
+  pattern = VIBRATION_STEADY;
   setPin(true);
   offAtMillis = millis() + durationMs;
   Serial.printf("[VIBRATION] Pulse triggered: %lu ms\n", (unsigned long)durationMs);
@@ -4,27 +4,55 @@
 #include <Arduino.h>
 #include "PinConfig.h"
 
+// The motor runs from LEDC so it can be driven at partial intensity
+#define VIBRATION_PWM_FREQUENCY 20000  // Above hearing range
+#define VIBRATION_PWM_RESOLUTION 8
+#define VIBRATION_MAX_DUTY ((1 << VIBRATION_PWM_RESOLUTION) - 1)
+
+// Ramp from standstill to full intensity, so the motor's start-up current
+// doesn't add to the servo inrush
+#define VIBRATION_SOFT_START_MS 300
+
+#define VIBRATION_PULSE_ON_MS 150
+#define VIBRATION_PULSE_OFF_MS 100
+#define VIBRATION_RAMP_PERIOD_MS 1000
+#define VIBRATION_RAMP_MIN_PERCENT 40
+
+enum VibrationPattern : uint8_t {
+  VIBRATION_STEADY,  // Constant full intensity
+  VIBRATION_PULSES,  // On/off train: repeated knocks break up bridged feed
+  VIBRATION_RAMP     // Intensity swept up and down, passes the hopper's resonance
+};
+#define VIBRATION_PATTERN_COUNT (VIBRATION_RAMP + 1)
+
 class VibrationService {
 public:
   VibrationService();
   void update();  // Must be called in loop()
 
   // Continuous shake driven by a feed cycle (start/during/after)
-  void startFeedShake();
+  void startFeedShake(VibrationPattern pattern = VIBRATION_STEADY);
   void endFeedShake(uint32_t tailMs);
 
   // Single timed pulse (manual trigger / idle shake schedule)
   void triggerPulse(uint32_t durationMs);
 
   bool isActive() const { return pinOn; }
+  uint32_t getDuty() const { return duty; }  // Currently written to LEDC
   static constexpr bool isCompiledIn() { return VIBRATION_MOTOR_ENABLED; }
 
 private:
   bool pinOn = false;
   bool feedShakeForced = false;
+  bool pwmAttached = false;
+  VibrationPattern pattern = VIBRATION_STEADY;
+  unsigned long startedAtMillis = 0;
   unsigned long offAtMillis = 0;
+  uint32_t duty = 0;
 
   void setPin(bool on);
+  void writeDuty(uint32_t value);
+  uint32_t dutyAt(unsigned long now) const;
 };
 
 #endif // VIBRATION_SERVICE_HPP
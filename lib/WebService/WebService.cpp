@@ -2,6 +2,7 @@
 #include "SchedulingService.hpp"
 #include "generated/web_files.h"
 #include <WiFi.h>
+#include <esp_timer.h>
 #include <cctype>
 
 std::vector<uint8_t>* WebService::accumulateBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total, size_t maxSize) {
@@ -173,6 +174,20 @@ void WebService::setupRoutes() {
         handleGetStatus(request);
     });
 
+    server.on("/api/metrics/feeding", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        updateClientActivity();
+        handleGetFeedMetrics(request);
+    });
+
+    server.on("/api/metrics/feeding", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
+        updateClientActivity();
+        feedingService.resetMetrics();
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Feed metrics reset";
+        sendJsonResponse(request, doc);
+    });
+
     server.on("/api/config", HTTP_GET, [this](AsyncWebServerRequest *request) {
         updateClientActivity();
         handleGetConfig(request);
@@ -184,6 +199,18 @@ void WebService::setupRoutes() {
         handlePostConfig(request, data, len, index, total);
     });
 
+    // Must precede /api/feed, which would also match it as a prefix
+    server.on("/api/feed/calibrate", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        updateClientActivity();
+        sendCalibration(request);
+    });
+
+    server.on("/api/feed/calibrate", HTTP_POST, [](AsyncWebServerRequest *request) {},
+              NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        updateClientActivity();
+        handlePostCalibrate(request, data, len, index, total);
+    });
+
     server.on("/api/feed", HTTP_POST, [this](AsyncWebServerRequest *request) {
         updateClientActivity();
         handlePostFeed(request);
@@ -194,6 +221,13 @@ void WebService::setupRoutes() {
         handlePostVibrate(request);
     });
 
+    // Must precede /api/time, which would also match it as a prefix
+    server.on("/api/time/echo", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        int64_t receivedUs = esp_timer_get_time();
+        updateClientActivity();
+        handleTimeEcho(request, receivedUs);
+    });
+
     server.on("/api/time", HTTP_GET, [this](AsyncWebServerRequest *request) {
         updateClientActivity();
         handleGetTime(request);
@@ -322,6 +356,8 @@ void WebService::handleGetStatus(AsyncWebServerRequest *request) {
     JsonObject data = doc["data"].to<JsonObject>();
     data["isOnline"] = true;
     data["isFeeding"] = feedingService.isFeeding();
+    // Changes whenever any setting or schedule does
+    data["configGeneration"] = configService.getGeneration();
 
     // Servo position
     const char* position = "Closed";
@@ -342,8 +378,99 @@ void WebService::handleGetStatus(AsyncWebServerRequest *request) {
         data["lastFeedTime"] = nullptr;
     }
 
-    // Total fed today (placeholder - would need to track this)
-    data["totalFedToday"] = 0;
+    // Grams fed since local midnight
+    uint32_t fedToday = 0;
+    DateTime now = clockService.now();
+    if (now.isValid()) {
+        uint32_t local = clockService.toLocal(now.unixtime());
+        uint32_t midnight = clockService.toUtc(local - local % SECONDS_PER_DAY);
+        fedToday = feedingService.getGramsBetween(midnight, now.unixtime() + 1);
+    }
+    data["totalFedToday"] = fedToday;
+
+    const FeedQueueStats &queueStats = feedingService.getQueueStats();
+    JsonObject feedQueue = data["feedQueue"].to<JsonObject>();
+    feedQueue["depth"] = feedingService.getQueueDepth();
+    feedQueue["capacity"] = FEED_QUEUE_SIZE;
+    feedQueue["oldestWaitMs"] = feedingService.getOldestQueuedWaitMs();
+    feedQueue["lastWaitMs"] = queueStats.lastWaitMs;
+    feedQueue["maxWaitMs"] = queueStats.maxWaitMs;
+    feedQueue["queued"] = queueStats.queued;
+    feedQueue["merged"] = queueStats.merged;
+    feedQueue["dropped"] = queueStats.dropped;
+
+    const FeedCycleStats &cycle = feedingService.getCycleStats();
+    JsonObject feedCycle = data["feedCycle"].to<JsonObject>();
+    feedCycle["portions"] = cycle.cycles;
+    feedCycle["lastMs"] = cycle.lastCycleMs;
+    feedCycle["minMs"] = cycle.minCycleMs;
+    feedCycle["maxMs"] = cycle.maxCycleMs;
+    feedCycle["lastSequenceMs"] = cycle.lastSequenceMs;
+    feedCycle["lastSequencePortions"] = cycle.lastSequencePortions;
+
+    // Light barrier verification (all zero without one)
+    const DispenseStats &dispense = feedingService.getDispenseStats();
+    static const char* const FAULT_NAMES[] = {"none", "empty", "jam"};
+    JsonObject dispensed = data["dispense"].to<JsonObject>();
+    dispensed["lightBarrier"] = LightBarrierService::isCompiledIn();
+    dispensed["verified"] = dispense.verifiedPortions;
+    dispensed["short"] = dispense.shortPortions;
+    dispensed["empty"] = dispense.emptyPortions;
+    dispensed["earlyCloses"] = dispense.earlyCloses;
+    dispensed["earlyFeedEnds"] = dispense.earlyFeedEnds;
+    dispensed["lastPulses"] = dispense.lastPulses;
+    dispensed["fault"] = FAULT_NAMES[dispense.lastFault];
+
+    // Where the last scheduled wake spent its time before the hopper opened
+    const WakeTiming &wake = schedulingService.getWakeTiming();
+    JsonObject wakeTiming = data["wakeTiming"].to<JsonObject>();
+    wakeTiming["bootMs"] = wake.bootUs / 1000;
+    wakeTiming["setupMs"] = wake.setupUs / 1000;
+    wakeTiming["initMs"] = wake.initUs / 1000;
+    wakeTiming["warmupMs"] = wake.warmupUs / 1000;
+    wakeTiming["holdMs"] = wake.holdUs / 1000;
+    wakeTiming["latenessMs"] = wake.latenessMs;
+    wakeTiming["maxLatenessMs"] = wake.maxLatenessMs;
+    wakeTiming["budgetMs"] = wake.budgetUs / 1000;
+    wakeTiming["leadSeconds"] = schedulingService.getWakeLeadSeconds();
+    wakeTiming["feeds"] = wake.feeds;
+
+    sendJsonResponse(request, doc);
+}
+
+static void addTimingHistogram(JsonObject out, const TimingHistogram &histogram) {
+    uint32_t count = 0;
+    JsonArray buckets = out["buckets"].to<JsonArray>();
+    for (uint8_t i = 0; i < TIMING_BUCKET_COUNT; i++) {
+        buckets.add(histogram.counts[i]);
+        count += histogram.counts[i];
+    }
+    out["count"] = count;
+    out["meanMs"] = count > 0 ? histogram.totalMs / count : 0;
+    out["maxMs"] = histogram.maxMs;
+}
+
+void WebService::handleGetFeedMetrics(AsyncWebServerRequest *request) {
+    static const char* const stateNames[SERVO_STATE_COUNT] = {
+        "IDLE", "POWER_ON", "ATTACH_SERVOS", "SERVO_READY", "MOVING", "DETACH_SERVOS", "POWER_OFF", "FEED_WAITING",
+        "PRE_AGITATE"
+    };
+    const FeedMetrics &metrics = feedingService.getMetrics();
+
+    JsonDocument doc;
+    doc["success"] = true;
+
+    JsonObject data = doc["data"].to<JsonObject>();
+    JsonArray limits = data["bucketLimitsMs"].to<JsonArray>();
+    for (uint8_t i = 0; i < TIMING_BUCKET_COUNT - 1; i++) {
+        limits.add(TIMING_BUCKET_LIMITS_MS[i]);
+    }
+
+    JsonObject states = data["states"].to<JsonObject>();
+    for (uint8_t i = POWER_ON; i < SERVO_STATE_COUNT; i++) {
+        addTimingHistogram(states[stateNames[i]].to<JsonObject>(), metrics.states[i]);
+    }
+    addTimingHistogram(data["portion"].to<JsonObject>(), metrics.portion);
 
     sendJsonResponse(request, doc);
 }
@@ -353,45 +480,32 @@ void WebService::handleGetFeedHistory(AsyncWebServerRequest *request) {
 
     doc["success"] = true;
 
-    // Get limit parameter from query string (default 10)
+    // Get limit parameter from query string (default 10); offset pages
+    // further back through the feed log
     int limit = 10;
     if (request->hasParam("limit")) {
         limit = request->getParam("limit")->value().toInt();
         if (limit < 1) limit = 1;
-        if (limit > 100) limit = 100;
+        if (limit > MAX_FEED_HISTORY_PAGE) limit = MAX_FEED_HISTORY_PAGE;
+    }
+    int offset = 0;
+    if (request->hasParam("offset")) {
+        offset = request->getParam("offset")->value().toInt();
+        if (offset < 0) offset = 0;
+        if (offset > UINT16_MAX) offset = UINT16_MAX;
     }
 
     JsonObject data = doc["data"].to<JsonObject>();
     JsonArray feeds = data["feeds"].to<JsonArray>();
 
-    // Get feed history from FeedingService
-    uint8_t count = feedingService.getFeedHistoryCount();
-    const FeedHistoryEntry* history = feedingService.getFeedHistory();
-
-    Serial.printf("[WEB] Feed history request: count=%d, limit=%d\n", count, limit);
-
-    // Get portion unit grams for calculating total grams
-    uint8_t portionGrams = configService.getPortionUnitGrams();
+    // Newest first, from the feed log or the RAM ring
+    FeedHistoryEntry history[MAX_FEED_HISTORY_PAGE];
+    uint16_t count = feedingService.readFeedHistory(history, limit, offset);
 
-    // Limit the number of entries returned
-    if (count > limit) {
-        count = limit;
-    }
-
-    // Add entries to JSON array (newest first)
-    // Ring buffer: feedHistoryIndex points to the next write position.
-    uint8_t historyCount = feedingService.getFeedHistoryCount();
-    uint8_t writeIndex = feedingService.getFeedHistoryWriteIndex();
-    for (uint8_t i = 0; i < count; i++) {
-        uint8_t ringIndex = (writeIndex + MAX_FEED_HISTORY - 1 - i) % MAX_FEED_HISTORY;
-        const FeedHistoryEntry& entry = history[ringIndex];
+    Serial.printf("[WEB] Feed history request: count=%d, limit=%d, offset=%d\n", count, limit, offset);
 
-        Serial.printf("[WEB] Entry %d (ring %d): timestamp=%lu, portion_units=%d\n", i, ringIndex, entry.timestamp, entry.portion_units);
-
-        if (entry.timestamp == 0) {
-            Serial.printf("[WEB] Skipping empty entry at index %d\n", i);
-            continue; // Skip empty entries
-        }
+    for (uint16_t i = 0; i < count; i++) {
+        const FeedHistoryEntry& entry = history[i];
 
         JsonObject feed = feeds.add<JsonObject>();
 
@@ -402,11 +516,22 @@ void WebService::handleGetFeedHistory(AsyncWebServerRequest *request) {
                  dt.year(), dt.month(), dt.day(), dt.hour(), dt.minute(), dt.second());
         feed["timestamp"] = buf;
 
-        // Calculate portion in grams
-        uint16_t portionTotal = entry.portion_units * portionGrams;
-        feed["portion"] = portionTotal;
+        // Grams as fed, not at today's portion size
+        feed["portion"] = entry.grams;
+        if (entry.tag == FEED_TAG_WEB) {
+            feed["source"] = "web";
+        } else if (entry.tag == FEED_TAG_BUTTON) {
+            feed["source"] = "button";
+        } else if (entry.tag >= FEED_TAG_SCHEDULE && entry.tag <= FEED_TAG_SCHEDULE_ID(MAX_SCHEDULES)) {
+            feed["source"] = "schedule";
+            if (entry.tag > FEED_TAG_SCHEDULE) {
+                feed["scheduleId"] = entry.tag - FEED_TAG_SCHEDULE;
+            }
+        } else {
+            feed["source"] = nullptr;
+        }
 
-        Serial.printf("[WEB] Added feed to response: %s, %dg\n", buf, portionTotal);
+        Serial.printf("[WEB] Added feed to response: %s, %dg\n", buf, entry.grams);
     }
 
     Serial.printf("[WEB] Sending %d feed entries\n", feeds.size());
@@ -415,6 +540,18 @@ void WebService::handleGetFeedHistory(AsyncWebServerRequest *request) {
 }
 
 void WebService::handleGetConfig(AsyncWebServerRequest *request) {
+    // The config generation is the ETag: the browser revalidates with it and
+    // gets a bodyless 304 until something changes
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)configService.getGeneration());
+    if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag) {
+        AsyncWebServerResponse *response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+        return;
+    }
+
     JsonDocument doc;
 
     doc["success"] = true;
@@ -423,15 +560,25 @@ void WebService::handleGetConfig(AsyncWebServerRequest *request) {
     data["version"] = 1;
     data["portion_unit_grams"] = configService.getPortionUnitGrams();
     data["manual_portion_units"] = configService.getManualPortionUnits();
+    data["batch_window_minutes"] = configService.getBatchWindowMinutes();
+    data["timezone"] = configService.getTimeZone();
+    data["servo_close_angle"] = configService.getServoCloseAngle();
+    data["servo_open_angle"] = configService.getServoOpenAngle();
+    data["open_dwell_ms"] = configService.getOpenDwellMs();
+    data["portion_gap_ms"] = configService.getPortionGapMs();
+    data["light_barrier_available"] = LightBarrierService::isCompiledIn();
+    data["barrier_pulses_per_portion"] = configService.getBarrierPulsesPerPortion();
     data["vibration_available"] = VibrationService::isCompiledIn();
     data["vibration_enabled"] = configService.isVibrationEnabled();
     data["vibration_pulse_seconds"] = configService.getVibrationPulseSeconds();
+    data["vibration_pattern"] = configService.getVibrationPattern();
+    data["pre_agitation_ms"] = configService.getPreAgitationMs();
 
     JsonArray schedules = data["schedules"].to<JsonArray>();
 
-    Schedule schedule;
-    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
-        if (configService.loadSchedule(i, schedule)) {
+    Schedule stored[MAX_SCHEDULES];
+    if (configService.loadAllSchedules(stored)) {
+        for (const Schedule &schedule : stored) {
             JsonObject s = schedules.add<JsonObject>();
             s["id"] = schedule.id;
             s["enabled"] = schedule.enabled;
@@ -441,7 +588,7 @@ void WebService::handleGetConfig(AsyncWebServerRequest *request) {
         }
     }
 
-    sendJsonResponse(request, doc);
+    sendJsonResponse(request, doc, 200, etag);
 }
 
 void WebService::handlePostConfig(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
@@ -457,23 +604,28 @@ void WebService::handlePostConfig(AsyncWebServerRequest *request, uint8_t *data,
         return;
     }
 
-    // Save schedules if provided
-    if (!doc["schedules"].isNull()) {
+    // Validate everything first: a bad field rejects the whole request
+    // and leaves every setting as it was
+    bool hasSchedules = !doc["schedules"].isNull();
+    Schedule updated[MAX_SCHEDULES];
+    if (hasSchedules) {
         JsonArray schedules = doc["schedules"];
 
+        // Slots not in the request keep what they have (defaults if the
+        // stored ones are unreadable); all go out in one write
+        configService.loadAllSchedules(updated);
+
         for (uint8_t i = 0; i < schedules.size() && i < MAX_SCHEDULES; i++) {
             JsonObject s = schedules[i];
 
             const char* timeStr = s["time"] | "00:00";
-            bool validTime = strlen(timeStr) == 5 && timeStr[2] == ':' &&
-                             isdigit((unsigned char)timeStr[0]) && isdigit((unsigned char)timeStr[1]) &&
-                             isdigit((unsigned char)timeStr[3]) && isdigit((unsigned char)timeStr[4]);
-            if (!validTime) {
+            uint16_t minuteOfDay;
+            if (!parseScheduleTime(timeStr, minuteOfDay)) {
                 sendError(request, "Invalid time format. Must be HH:MM.", 400);
                 return;
             }
 
-            Schedule schedule;
+            Schedule &schedule = updated[i];
             schedule.id = s["id"] | (i + 1);
             schedule.enabled = s["enabled"] | false;
             strncpy(schedule.time, timeStr, sizeof(schedule.time) - 1);
@@ -486,28 +638,63 @@ void WebService::handlePostConfig(AsyncWebServerRequest *request, uint8_t *data,
                 sendError(request, "Invalid portion size. Must be between 1-10 units.", 400);
                 return;
             }
-
-            configService.saveSchedule(i, schedule);
         }
     }
 
-    // Update portion unit grams if provided
-    if (!doc["portion_unit_grams"].isNull()) {
-        uint8_t grams = doc["portion_unit_grams"];
-        configService.setPortionUnitGrams(grams);
-    }
-
     if (!doc["manual_portion_units"].isNull()) {
         uint8_t units = doc["manual_portion_units"];
         if (units < 1 || units > 10) {
             sendError(request, "Invalid manual feed amount. Must be between 1-10 units.", 400);
             return;
         }
-        configService.setManualPortionUnits(units);
     }
 
-    if (!doc["vibration_enabled"].isNull()) {
-        configService.setVibrationEnabled(doc["vibration_enabled"] | true);
+    if (!doc["batch_window_minutes"].isNull()) {
+        uint8_t minutes = doc["batch_window_minutes"];
+        if (minutes > MAX_BATCH_WINDOW_MINUTES) {
+            sendError(request, "Invalid batching window. Must be between 0-30 minutes.", 400);
+            return;
+        }
+    }
+
+    if (!doc["timezone"].isNull()) {
+        const char* tz = doc["timezone"] | "";
+        if (!TimeZone::isValid(tz)) {
+            sendError(request, "Invalid timezone. Expected a POSIX TZ rule like CET-1CEST,M3.5.0,M10.5.0/3.", 400);
+            return;
+        }
+    }
+
+    bool hasServoAngles = !doc["servo_close_angle"].isNull() || !doc["servo_open_angle"].isNull();
+    int closeAngle = doc["servo_close_angle"] | (int)configService.getServoCloseAngle();
+    int openAngle = doc["servo_open_angle"] | (int)configService.getServoOpenAngle();
+    if (hasServoAngles && (closeAngle < 0 || openAngle > 180 || openAngle < closeAngle + MIN_SERVO_TRAVEL_DEG)) {
+        sendError(request, "Invalid servo angles. Must be 0-180 with open at least 20 degrees past close.", 400);
+        return;
+    }
+
+    if (!doc["open_dwell_ms"].isNull()) {
+        int ms = doc["open_dwell_ms"];
+        if (ms < MIN_OPEN_DWELL_MS || ms > MAX_DWELL_MS) {
+            sendError(request, "Invalid open dwell. Must be between 100-5000 ms.", 400);
+            return;
+        }
+    }
+
+    if (!doc["portion_gap_ms"].isNull()) {
+        int ms = doc["portion_gap_ms"];
+        if (ms < 0 || ms > MAX_DWELL_MS) {
+            sendError(request, "Invalid portion gap. Must be between 0-5000 ms.", 400);
+            return;
+        }
+    }
+
+    if (!doc["barrier_pulses_per_portion"].isNull()) {
+        int pulses = doc["barrier_pulses_per_portion"];
+        if (pulses < 0 || pulses > MAX_BARRIER_PULSES_PER_PORTION) {
+            sendError(request, "Invalid light barrier pulses per portion. Must be between 0-200.", 400);
+            return;
+        }
     }
 
     if (!doc["vibration_pulse_seconds"].isNull()) {
@@ -516,30 +703,170 @@ void WebService::handlePostConfig(AsyncWebServerRequest *request, uint8_t *data,
             sendError(request, "Invalid vibration pulse duration. Must be between 1-30 seconds.", 400);
             return;
         }
-        configService.setVibrationPulseSeconds(seconds);
     }
 
+    if (!doc["vibration_pattern"].isNull()) {
+        int pattern = doc["vibration_pattern"];
+        if (pattern < 0 || pattern >= VIBRATION_PATTERN_COUNT) {
+            sendError(request, "Invalid vibration pattern. Must be 0 (steady), 1 (pulses) or 2 (ramp).", 400);
+            return;
+        }
+    }
+
+    if (!doc["pre_agitation_ms"].isNull()) {
+        int ms = doc["pre_agitation_ms"];
+        if (ms < 0 || ms > MAX_PRE_AGITATION_MS) {
+            sendError(request, "Invalid pre-agitation. Must be between 0-3000 ms.", 400);
+            return;
+        }
+    }
+
+    // Then apply; schedules first, the only write that can fail here
+    if (hasSchedules && !configService.saveAllSchedules(updated)) {
+        sendError(request, "Failed to save schedules", 500);
+        return;
+    }
+
+    if (!doc["portion_unit_grams"].isNull()) {
+        configService.setPortionUnitGrams(doc["portion_unit_grams"].as<uint8_t>());
+    }
+    if (!doc["manual_portion_units"].isNull()) {
+        configService.setManualPortionUnits(doc["manual_portion_units"].as<uint8_t>());
+    }
+    if (!doc["batch_window_minutes"].isNull()) {
+        configService.setBatchWindowMinutes(doc["batch_window_minutes"].as<uint8_t>());
+    }
+    if (!doc["timezone"].isNull()) {
+        const char* tz = doc["timezone"] | "";
+        clockService.setTimeZone(tz);
+        configService.setTimeZone(tz);
+    }
+    if (hasServoAngles) {
+        configService.setServoAngles(closeAngle, openAngle);
+    }
+    if (!doc["open_dwell_ms"].isNull()) {
+        configService.setOpenDwellMs(doc["open_dwell_ms"].as<int>());
+    }
+    if (!doc["portion_gap_ms"].isNull()) {
+        configService.setPortionGapMs(doc["portion_gap_ms"].as<int>());
+    }
+    if (!doc["barrier_pulses_per_portion"].isNull()) {
+        configService.setBarrierPulsesPerPortion(doc["barrier_pulses_per_portion"].as<int>());
+    }
+    if (!doc["vibration_enabled"].isNull()) {
+        configService.setVibrationEnabled(doc["vibration_enabled"] | true);
+    }
+    if (!doc["vibration_pulse_seconds"].isNull()) {
+        configService.setVibrationPulseSeconds(doc["vibration_pulse_seconds"].as<uint8_t>());
+    }
+    if (!doc["vibration_pattern"].isNull()) {
+        configService.setVibrationPattern(doc["vibration_pattern"].as<int>());
+    }
+    if (!doc["pre_agitation_ms"].isNull()) {
+        configService.setPreAgitationMs(doc["pre_agitation_ms"].as<int>());
+    }
+
+    // Notify scheduling service of config change
+    schedulingService.onConfigChanged();
+
     JsonDocument response;
     response["success"] = true;
     response["message"] = "Configuration saved successfully";
 
-    // Notify scheduling service of config change
-    schedulingService.onConfigChanged();
+    // Compiling the week bitmap detects schedules sharing a minute for free;
+    // they are merged into one feed, but tell the user about it
+    uint8_t overlapCount = schedulingService.getOverlapCount();
+    if (overlapCount > 0) {
+        JsonArray overlaps = response["overlaps"].to<JsonArray>();
+        const WeekOverlap* list = schedulingService.getOverlaps();
+        for (uint8_t i = 0; i < overlapCount && i < MAX_WEEK_OVERLAPS; i++) {
+            JsonObject o = overlaps.add<JsonObject>();
+            o["weekday"] = list[i].minuteOfWeek / MINUTES_PER_DAY;
+            char timeBuf[6];
+            snprintf(timeBuf, sizeof(timeBuf), "%02u:%02u",
+                     (list[i].minuteOfWeek % MINUTES_PER_DAY) / 60, list[i].minuteOfWeek % 60);
+            o["time"] = timeBuf;
+            JsonArray ids = o["schedule_ids"].to<JsonArray>();
+            ids.add(list[i].firstId);
+            ids.add(list[i].secondId);
+        }
+        response["overlap_count"] = overlapCount;
+    }
 
     sendJsonResponse(request, response);
 }
 
 void WebService::handlePostFeed(AsyncWebServerRequest *request) {
-    if (feedingService.isFeeding()) {
-        sendError(request, "Feeder is already active", 400);
+    // Started, queued or merged by the loop task on its next pass
+    feedingService.requestFeed(configService.getManualPortionUnits(), FEED_SOURCE_WEB);
+
+    JsonDocument doc;
+    doc["success"] = true;
+    doc["message"] = "Feed requested";
+    doc["queueDepth"] = feedingService.getQueueDepth();
+
+    sendJsonResponse(request, doc);
+}
+
+void WebService::handlePostCalibrate(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    std::vector<uint8_t>* body = accumulateBody(request, data, len, index, total, MAX_POST_BODY_BYTES);
+    if (!body) return;
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, body->data(), body->size());
+    delete body;
+
+    if (error) {
+        sendError(request, "Invalid JSON", 400);
         return;
     }
 
-    feedingService.feed(configService.getManualPortionUnits());
+    const char* action = doc["action"] | "";
+    if (strcmp(action, "start") == 0) {
+        if (!feedingService.requestCalibration(CALIBRATION_START)) {
+            sendError(request, "Feeder is already active", 400);
+            return;
+        }
+    } else if (strcmp(action, "result") == 0) {
+        if (doc["full_unit"].isNull()) {
+            sendError(request, "Missing full_unit", 400);
+            return;
+        }
+        bool fullUnit = doc["full_unit"] | false;
+        if (!feedingService.requestCalibration(fullUnit ? CALIBRATION_FULL_UNIT : CALIBRATION_TOO_LITTLE)) {
+            sendError(request, feedingService.getCalibration().active ? "Test portion still dispensing"
+                                                                      : "No calibration in progress", 400);
+            return;
+        }
+    } else if (strcmp(action, "cancel") == 0) {
+        if (!feedingService.requestCalibration(CALIBRATION_CANCEL)) {
+            sendError(request, "Another calibration step is pending", 400);
+            return;
+        }
+    } else {
+        sendError(request, "Invalid action. Must be start, result or cancel.", 400);
+        return;
+    }
+
+    sendCalibration(request);
+}
+
+void WebService::sendCalibration(AsyncWebServerRequest *request) {
+    const ServoCalibration &calibration = feedingService.getCalibration();
 
     JsonDocument doc;
     doc["success"] = true;
-    doc["message"] = "Feed cycle started";
+    JsonObject data = doc["data"].to<JsonObject>();
+    data["active"] = calibration.active;
+    // A request is carried out by the main loop; until then the rest of
+    // the state is from before it
+    data["pending"] = feedingService.isCalibrationPending();
+    data["dispensing"] = feedingService.isFeeding();
+    data["test_angle"] = calibration.testAngle;
+    data["low_angle"] = calibration.lowAngle;
+    data["high_angle"] = calibration.highAngle;
+    data["trials"] = calibration.trials;
+    data["servo_open_angle"] = configService.getServoOpenAngle();
 
     sendJsonResponse(request, doc);
 }
@@ -575,7 +902,8 @@ void WebService::handleSleep(AsyncWebServerRequest *request) {
 }
 
 void WebService::handleGetTime(AsyncWebServerRequest *request) {
-    DateTime now = clockService.now();
+    ClockSnapshot clock = clockService.snapshot();
+    const DateTime &now = clock.local;
 
     JsonDocument response;
     response["success"] = true;
@@ -587,8 +915,21 @@ void WebService::handleGetTime(AsyncWebServerRequest *request) {
     data["hour"] = now.hour();
     data["minute"] = now.minute();
     data["second"] = now.second();
-    data["timezone"] = clockService.getCurrentTimeZoneName();
-    data["utc_offset_seconds"] = clockService.getCurrentUtcOffsetSeconds();
+    data["timezone"] = clock.timeZoneName;
+    data["utc_offset_seconds"] = clock.utcOffsetSeconds;
+    data["aging_offset"] = clockService.getAgingOffset();
+    data["drift_residual_ppb"] = clockService.getDriftResidualPpb();
+    static const char* const SYNC_STATES[] = {"none", "pending", "done", "failed"};
+    data["sync"] = SYNC_STATES[clockService.getSyncState()];
+
+    const Ds3231BusStats &bus = clockService.getBusStats();
+    JsonObject i2c = data["i2c"].to<JsonObject>();
+    i2c["transactions"] = bus.transactions;
+    i2c["failures"] = bus.failures;
+    i2c["recoveries"] = bus.recoveries;
+    i2c["last_us"] = bus.lastUs;
+    i2c["max_us"] = bus.maxUs;
+    i2c["avg_us"] = bus.transactions > 0 ? (uint32_t)(bus.totalUs / bus.transactions) : 0;
 
     sendJsonResponse(request, response);
 }
@@ -606,6 +947,11 @@ void WebService::handlePostTime(AsyncWebServerRequest *request, uint8_t *data, s
         return;
     }
 
+    if (!doc["t0"].isNull()) {
+        handleTimeSync(request, doc);
+        return;
+    }
+
     if (doc["unixTime"].isNull()) {
         sendError(request, "Missing unixTime field", 400);
         return;
@@ -625,12 +971,67 @@ void WebService::handlePostTime(AsyncWebServerRequest *request, uint8_t *data, s
     sendJsonResponse(request, response);
 }
 
+void WebService::handleTimeEcho(AsyncWebServerRequest *request, int64_t receivedUs) {
+    JsonDocument doc;
+    doc["success"] = true;
+
+    // Device side of an NTP-style exchange, in esp_timer microseconds
+    JsonObject data = doc["data"].to<JsonObject>();
+    data["t1"] = receivedUs;
+    data["t2"] = esp_timer_get_time();
+
+    sendJsonResponse(request, doc);
+}
+
+void WebService::handleTimeSync(AsyncWebServerRequest *request, JsonDocument &doc) {
+    // t0/t3: client send/receive time of the echo request (Unix ms)
+    // t1/t2: device receive/send time from the echo (esp_timer µs)
+    if (doc["t1"].isNull() || doc["t2"].isNull() || doc["t3"].isNull()) {
+        sendError(request, "Missing t1, t2 or t3 field", 400);
+        return;
+    }
+    int64_t t0 = doc["t0"].as<int64_t>() * 1000;
+    int64_t t1 = doc["t1"].as<int64_t>();
+    int64_t t2 = doc["t2"].as<int64_t>();
+    int64_t t3 = doc["t3"].as<int64_t>() * 1000;
+
+    int64_t nowUs = esp_timer_get_time();
+    int64_t roundTripUs = (t3 - t0) - (t2 - t1);
+    if (t1 > t2 || t2 > nowUs || nowUs - t2 > MAX_TIME_ECHO_AGE_US ||
+        roundTripUs < 0 || roundTripUs > MAX_TIME_ROUND_TRIP_US) {
+        sendError(request, "Stale or inconsistent time echo", 400);
+        return;
+    }
+
+    // Assumes the request and the response took equally long; the error is
+    // at most half the round trip
+    int64_t utcOffsetUs = ((t0 - t1) + (t3 - t2)) / 2;
+    if (!clockService.syncTime(utcOffsetUs)) {
+        sendError(request, "Failed to set time", 500);
+        return;
+    }
+
+    JsonDocument response;
+    response["success"] = true;
+    response["message"] = "Time sync scheduled";
+    response["round_trip_ms"] = (uint32_t)(roundTripUs / 1000);
+
+    sendJsonResponse(request, response);
+}
+
 void WebService::handleResetConfig(AsyncWebServerRequest *request) {
     if (!configService.resetToDefaults()) {
         sendError(request, "Failed to reset configuration", 500);
         return;
     }
 
+    // NVS history is gone; the copy in RAM and the feed log go with it
+    feedingService.clearFeedHistory();
+
+    // Default schedules replace the compiled week and the armed alarm
+    clockService.setTimeZone(configService.getTimeZone());
+    schedulingService.onConfigChanged();
+
     JsonDocument doc;
     doc["success"] = true;
     doc["message"] = "Configuration reset to defaults";
@@ -638,12 +1039,17 @@ void WebService::handleResetConfig(AsyncWebServerRequest *request) {
     sendJsonResponse(request, doc);
 }
 
-void WebService::sendJsonResponse(AsyncWebServerRequest *request, JsonDocument &doc, int statusCode) {
+void WebService::sendJsonResponse(AsyncWebServerRequest *request, JsonDocument &doc, int statusCode,
+                                  const char *etag) {
     String output;
     serializeJson(doc, output);
 
     AsyncWebServerResponse *response = request->beginResponse(statusCode, "application/json", output);
     response->addHeader("Access-Control-Allow-Origin", "*");
+    if (etag) {
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache");
+    }
     request->send(response);
 }
 
@@ -709,6 +1115,7 @@ void WebService::handleOtaUpdate(AsyncWebServerRequest *request, const String& f
             sendJsonResponse(request, doc);
 
             // Reboot after response is sent
+            configService.flush();
             delay(100);
             ESP.restart();
         } else {
@@ -16,6 +16,9 @@
 // Forward declaration to avoid circular dependency
 class SchedulingService;
 
+// Most feed history entries per /api/status/history request
+#define MAX_FEED_HISTORY_PAGE 100
+
 class WebService {
 public:
     WebService(ConfigService &config, ClockService &clock, FeedingService &feeding, SchedulingService &scheduling, VibrationService &vibration);
@@ -49,6 +52,10 @@ private:
     static const uint8_t DNS_PORT = 53;
     static const uint8_t AP_WIFI_CHANNEL = 6;  // avoid the commonly-congested default channel 1
     static const size_t MAX_POST_BODY_BYTES = 4096;  // plenty for config/time JSON, rejects abuse
+    // Time sync: the echo must be recent and the round trip short enough
+    // for its midpoint to mean something
+    static const int64_t MAX_TIME_ECHO_AGE_US = 10000000;
+    static const int64_t MAX_TIME_ROUND_TRIP_US = 2000000;
     std::function<void()> sleepCallback;
     bool sleepRequested = false;
     uint32_t sleepRequestMillis = 0;
@@ -60,12 +67,17 @@ private:
     // API handlers
     void handleGetStatus(AsyncWebServerRequest *request);
     void handleGetFeedHistory(AsyncWebServerRequest *request);
+    void handleGetFeedMetrics(AsyncWebServerRequest *request);
     void handleGetConfig(AsyncWebServerRequest *request);
     void handleGetTime(AsyncWebServerRequest *request);
     void handlePostConfig(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
     void handlePostFeed(AsyncWebServerRequest *request);
+    void handlePostCalibrate(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+    void sendCalibration(AsyncWebServerRequest *request);
     void handlePostVibrate(AsyncWebServerRequest *request);
     void handlePostTime(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+    void handleTimeEcho(AsyncWebServerRequest *request, int64_t receivedUs);
+    void handleTimeSync(AsyncWebServerRequest *request, JsonDocument &doc);
     void handleResetConfig(AsyncWebServerRequest *request);
     void handleSleep(AsyncWebServerRequest *request);
     void handleOtaStatus(AsyncWebServerRequest *request);
@@ -81,7 +93,8 @@ private:
     // response has already been sent in that case). Returns a heap-allocated
     // buffer with the complete body once fully received - caller must delete it.
     std::vector<uint8_t>* accumulateBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total, size_t maxSize);
-    void sendJsonResponse(AsyncWebServerRequest *request, JsonDocument &doc, int statusCode = 200);
+    void sendJsonResponse(AsyncWebServerRequest *request, JsonDocument &doc, int statusCode = 200,
+                          const char *etag = nullptr);
     void sendError(AsyncWebServerRequest *request, const char* message, int statusCode = 400);
     void updateClientActivity();
 };
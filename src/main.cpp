@@ -1,5 +1,7 @@
 #include <Arduino.h>
+#include <algorithm>
 #include <esp_sleep.h>
+#include <esp_timer.h>
 
 #include "FeedingService.hpp"
 #include "ButtonService.hpp"
@@ -8,6 +10,9 @@
 #include "WebService.hpp"
 #include "SchedulingService.hpp"
 #include "VibrationService.hpp"
+#include "LightBarrierService.hpp"
+#include "FeedLogService.hpp"
+#include "PowerService.hpp"
 #include "PinConfig.h"
 
 // Power management
@@ -18,6 +23,8 @@ void simpleClickHandler(Button2 &btn);
 void doubleClickHandler(Button2 &btn);
 void longClickHandler(Button2 &btn);
 void enterDeepSleep(const char* reason);
+void migrateRtcToUtc();
+void migrateHistoryToFeedLog();
 void markActivity();
 void handleSleepLogic();
 
@@ -27,6 +34,9 @@ FeedingService feedingService;
 ClockService clockService;
 ConfigService configService;
 VibrationService vibrationService;
+LightBarrierService lightBarrierService;
+FeedLogService feedLogService;
+PowerService powerService;
 SchedulingService schedulingService(configService, clockService, feedingService);
 WebService webService(configService, clockService, feedingService, schedulingService, vibrationService);
 
@@ -38,8 +48,20 @@ unsigned long lastActivityMillis = 0;
 unsigned long ignoreButtonUntil = 0;
 
 void setup() {
+  // esp_timer starts at the wake-up reset - this is the boot time so far
+  const int64_t setupStartUs = esp_timer_get_time();
+
+  // Wake cause detection
+  esp_sleep_wakeup_cause_t wakeupReason = esp_sleep_get_wakeup_cause();
+  uint64_t gpioStatus = esp_sleep_get_gpio_wakeup_status();
+  wokeFromRtcAlarm = wakeupReason == ESP_SLEEP_WAKEUP_GPIO && (gpioStatus & (1ULL << RTC_INT_PIN));
+
   Serial.begin(115200);
-  delay(1000);
+  // Give a serial monitor time to attach - but not on a scheduled wake,
+  // where every millisecond here delays the feed
+  if (!wokeFromRtcAlarm) {
+    delay(1000);
+  }
 
   // Subscribe the main loop task to the framework's already-running task
   // watchdog (CONFIG_ESP_TASK_WDT, 10s timeout) - our only safety net against
@@ -51,18 +73,16 @@ void setup() {
   Serial.println("[INFO] ========================================\n");
 
   // Configure sleep callback for web API
-  webService.setSleepCallback([]() { enterDeepSleep("Remote request"); });
+  webService.setSleepCallback([]() { powerService.requestSleep("Remote request"); });
+  clockService.setConfigService(&configService);
   feedingService.setClockService(&clockService);
   feedingService.setConfigService(&configService);
   feedingService.setVibrationService(&vibrationService);
-
-  // Wake cause detection
-  esp_sleep_wakeup_cause_t wakeupReason = esp_sleep_get_wakeup_cause();
-  uint64_t gpioStatus = esp_sleep_get_gpio_wakeup_status();
+  feedingService.setLightBarrierService(&lightBarrierService);
+  feedingService.setFeedLogService(&feedLogService);
 
   if (wakeupReason == ESP_SLEEP_WAKEUP_GPIO) {
-    if (gpioStatus & (1ULL << RTC_INT_PIN)) {
-      wokeFromRtcAlarm = true;
+    if (wokeFromRtcAlarm) {
       Serial.println("[INFO] Wake reason: RTC alarm (GPIO)");
     }
     if (gpioStatus & (1ULL << BUTTON_PIN)) {
@@ -72,6 +92,11 @@ void setup() {
   } else {
     wokeFromPowerOn = true;
     Serial.println("[INFO] Wake reason: Power-on reset or unknown");
+    // No flash write is safe once the supply sags - settings changed in
+    // the last few seconds before it may not have been flushed
+    if (esp_reset_reason() == ESP_RST_BROWNOUT) {
+      Serial.println("[WARN] Reset by brownout - recent unsaved settings may be lost");
+    }
   }
 
   // Check for maintenance mode (button held during boot)
@@ -86,17 +111,50 @@ void setup() {
     Serial.println("[ERROR] Failed to initialize ConfigService!");
   }
 
-  // Initialize clock service
+  // Initialize clock service (local time follows the stored zone rule)
+  clockService.setTimeZone(configService.getTimeZone());
   if (!clockService.begin()) {
     Serial.println("[WARN] DS3231 RTC not available - time sync required");
   }
+  if (!configService.isRtcUtc()) {
+    migrateRtcToUtc();
+  }
 
-  // Load feed history from persistent storage
+  // Initialize feeding service; the barrier has to count from the first portion
+  lightBarrierService.begin();
+  feedingService.setup();
+
+  // Initialize scheduling service right away: on an RTC alarm wake it
+  // restores the compiled schedule from RTC memory and starts the due feed
+  // before anything else (history, buttons, web) is set up
+  if (wokeFromRtcAlarm) {
+    schedulingService.setBootStart(setupStartUs);
+  }
+  schedulingService.begin();
+
+  // Load feed history from persistent storage: the feed log partition,
+  // or NVS on a device still flashed with the old partition table
   FeedHistoryEntry history[MAX_FEED_HISTORY];
-  uint8_t historyWriteIndex = 0;
-  uint8_t historyCount = configService.loadFeedHistory(history, MAX_FEED_HISTORY, historyWriteIndex);
-  if (historyCount > 0) {
-    feedingService.loadFeedHistory(history, historyCount, historyWriteIndex);
+  if (feedLogService.begin()) {
+    migrateHistoryToFeedLog();
+    uint8_t count = feedLogService.readRecent(history, MAX_FEED_HISTORY);
+    // Newest first from the log, oldest first in the ring
+    std::reverse(history, history + count);
+    if (count > 0) {
+      feedingService.loadFeedHistory(history, count, count % MAX_FEED_HISTORY);
+    }
+  } else {
+    uint8_t historyWriteIndex = 0;
+    uint8_t historyCount = configService.loadFeedHistory(history, MAX_FEED_HISTORY, historyWriteIndex);
+    if (historyCount > 0) {
+      feedingService.loadFeedHistory(history, historyCount, historyWriteIndex);
+    }
+  }
+
+  // Feed timing histograms keep accumulating across sleeps
+  FeedMetrics metrics;
+  if (configService.loadFeedMetrics(metrics)) {
+    feedingService.loadMetrics(metrics);
   }
 
   // Initialize button service
@@ -105,12 +163,6 @@ void setup() {
   buttonService.setDoubleClickHandler(doubleClickHandler);
   buttonService.setLongClickHandler(longClickHandler);
 
-  // Initialize feeding service
-  feedingService.setup();
-
-  // Initialize scheduling service
-  schedulingService.begin();
-
   // Start web server
   if (!webService.begin()) {
     Serial.println("[ERROR] Failed to start WebService!");
@@ -140,12 +192,16 @@ void setup() {
     while (true) {
       feedLoopWDT();
       webService.update();
+      clockService.update(!feedingService.isFeeding() && !schedulingService.isHoldingFeed());
       feedingService.update();
       vibrationService.update();
       schedulingService.update();
+      configService.update(!feedingService.isFeeding() && !schedulingService.isHoldingFeed());
 
       if ((unsigned long)(millis() - webService.getLastClientActivity()) > MAINTENANCE_TIMEOUT_MS) {
         Serial.println("[MAINTENANCE] No activity for 15 minutes - rebooting to normal operation");
+        feedingService.flushFeedLog();
+        configService.flush();
         delay(100);
         ESP.restart();
       }
@@ -156,7 +212,8 @@ void setup() {
 
   // Handle wake-specific actions
   if (wokeFromRtcAlarm) {
-    // Process due events immediately (DS3231 alarm line stays low until cleared)
+    // Due events already ran in schedulingService.begin(); this releases the
+    // DS3231 alarm line (stays low until cleared) and keeps the next alarm
     schedulingService.checkAlarm();
   }
 
@@ -196,8 +253,12 @@ void loop() {
   buttonService.loop();
   feedingService.update();
   webService.update();
+  // A time sync stalls loop() while it measures - never during a feed
+  clockService.update(!feedingService.isFeeding() && !schedulingService.isHoldingFeed());
   schedulingService.update();
   vibrationService.update();
+  // Pending settings and history go to NVS between feeds, never during one
+  configService.update(!feedingService.isFeeding() && !schedulingService.isHoldingFeed());
   handleSleepLogic();
 }
 
@@ -226,12 +287,59 @@ void doubleClickHandler(Button2 &btn) {
   }
 
   Serial.println("[BUTTON] Double click - Manual feed");
-  feedingService.feed(configService.getManualPortionUnits());
+  feedingService.feed(configService.getManualPortionUnits(), FEED_SOURCE_BUTTON);
 }
 
 void longClickHandler(Button2 &btn) {
   Serial.println("[BUTTON] Long click - Entering deep sleep");
-  enterDeepSleep("Manual long press");
+  powerService.requestSleep("Manual long press");
+}
+
+void migrateRtcToUtc() {
+  // First boot after the switch to a UTC RTC: the DS3231 and the stored
+  // feed history still hold local time. Retried on the next boot if the
+  // RTC is not reachable right now.
+  if (!clockService.convertRtcToUtc()) {
+    return;
+  }
+
+  FeedHistoryEntry history[MAX_FEED_HISTORY];
+  uint8_t writeIndex = 0;
+  uint8_t count = configService.loadFeedHistory(history, MAX_FEED_HISTORY, writeIndex);
+  for (uint8_t i = 0; i < count; i++) {
+    if (history[i].timestamp > 0) {
+      history[i].timestamp = clockService.toUtc(history[i].timestamp);
+    }
+  }
+  if (count > 0) {
+    configService.saveFeedHistory(history, count, writeIndex);
+  }
+
+  configService.setRtcUtc(true);
+}
+
+void migrateHistoryToFeedLog() {
+  // First boot with the feed log: carry the NVS history over, oldest first
+  if (!feedLogService.isEmpty()) {
+    return;
+  }
+
+  FeedHistoryEntry history[MAX_FEED_HISTORY];
+  uint8_t writeIndex = 0;
+  uint8_t count = configService.loadFeedHistory(history, MAX_FEED_HISTORY, writeIndex);
+  if (count == 0) {
+    return;
+  }
+
+  uint8_t first = count < MAX_FEED_HISTORY ? 0 : writeIndex;
+  for (uint8_t i = 0; i < count; i++) {
+    const FeedHistoryEntry &entry = history[(first + i) % MAX_FEED_HISTORY];
+    if (entry.timestamp > 0) {
+      feedLogService.append(entry);
+    }
+  }
+  configService.clearFeedHistory();
+  Serial.printf("[INFO] Moved %d feed history entries from NVS to the feed log\n", count);
 }
 
 void markActivity() {
@@ -241,15 +349,20 @@ void markActivity() {
 void handleSleepLogic() {
   unsigned long now = millis();
 
-  // Skip sleeping while feeding
-  if (feedingService.isFeeding()) {
-    markActivity();
+  // Skip sleeping while feeding, while an early alarm waits for its feed,
+  // or while the post-feed vibration tail is still running (feed can
+  // finish and isFeeding() go false before the tail winds down)
+  bool busy = feedingService.isFeeding() || schedulingService.isHoldingFeed() ||
+              vibrationService.isActive();
+
+  // A long press or remote request waits for the same
+  const char* requested = powerService.update(busy);
+  if (requested) {
+    enterDeepSleep(requested);
     return;
   }
 
-  // Skip sleeping while the post-feed vibration tail is still running
-  // (feed can finish and isFeeding() go false before the tail winds down)
-  if (vibrationService.isActive()) {
+  if (busy) {
     markActivity();
     return;
   }
@@ -277,10 +390,12 @@ void handleSleepLogic() {
 void enterDeepSleep(const char* reason) {
   Serial.printf("[SLEEP] Entering deep sleep: %s\n", reason);
 
-  // Save feed history to persistent storage before sleeping
-  uint8_t historyCount = feedingService.getFeedHistoryCount();
-  if (historyCount > 0) {
-    configService.saveFeedHistory(feedingService.getFeedHistory(), historyCount, feedingService.getFeedHistoryWriteIndex());
+  // Whatever is still pending (settings, feed records) goes out now
+  feedingService.flushFeedLog();
+  configService.flush();
+  if (feedingService.isMetricsDirty()) {
+    configService.saveFeedMetrics(feedingService.getMetrics());
+    feedingService.markMetricsSaved();
   }
 
   // Ensure AP is stopped if it was running
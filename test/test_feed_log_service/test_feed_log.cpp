@@ -0,0 +1,193 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "FeedLogService.hpp"
+
+// Runs on the feedlog partition of the board it is flashed to, and
+// clears it before every test
+FeedLogService feedLog;
+bool logAvailable = false;
+
+static const uint32_t BASE_TIME = 1735689600;  // 2025-01-01 00:00:00 UTC
+static const uint32_t FEED_INTERVAL = 3600;
+
+// Feeds appended so far, and the feed that started each sector
+uint32_t appended = 0;
+uint32_t sectorStart[FEED_LOG_MAX_SECTORS + 1];
+uint8_t sectorsStarted = 0;
+
+FeedHistoryEntry feedAt(uint32_t i) {
+    FeedHistoryEntry entry = {BASE_TIME + i * FEED_INTERVAL, (uint16_t)(10 + i % 50), FEED_TAG_WEB};
+    return entry;
+}
+
+// A record is at most FEED_RECORD_MAX_SIZE bytes, so a bigger step (or
+// a drop, once the oldest sector was erased) means a new sector
+void appendNext() {
+    uint32_t before = feedLog.getUsedBytes();
+    TEST_ASSERT_TRUE(feedLog.append(feedAt(appended++)));
+    uint32_t after = feedLog.getUsedBytes();
+    if (before == 0 || after < before || after - before > FEED_RECORD_MAX_SIZE) {
+        sectorStart[sectorsStarted++] = appended - 1;
+    }
+}
+
+// Appends until the `count`th sector has just been started
+void fillSectors(uint8_t count) {
+    while (sectorsStarted < count) {
+        appendNext();
+    }
+}
+
+void assertFeed(uint32_t i, const FeedHistoryEntry &entry) {
+    FeedHistoryEntry expected = feedAt(i);
+    TEST_ASSERT_EQUAL_UINT32(expected.timestamp, entry.timestamp);
+    TEST_ASSERT_EQUAL_UINT16(expected.grams, entry.grams);
+    TEST_ASSERT_EQUAL_UINT8(expected.tag, entry.tag);
+}
+
+void setUp(void) {
+    if (!logAvailable) TEST_IGNORE_MESSAGE("No feedlog partition on this board");
+
+    TEST_ASSERT_TRUE(feedLog.clear());
+    appended = 0;
+    sectorsStarted = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_read_recent_skips_across_sectors(void) {
+    fillSectors(3);
+    for (uint8_t i = 0; i < 5; i++) {
+        appendNext();
+    }
+
+    // Start three records before the newest sector's first, read on into
+    // the one before it
+    uint32_t inNewest = appended - sectorStart[2];
+    uint16_t skip = inNewest - 3;
+    FeedHistoryEntry out[10];
+    TEST_ASSERT_EQUAL_UINT16(10, feedLog.readRecent(out, 10, skip));
+    for (uint8_t k = 0; k < 10; k++) {
+        assertFeed(appended - 1 - skip - k, out[k]);
+    }
+
+    // Skipping exactly the newest sector starts at the one before it
+    TEST_ASSERT_EQUAL_UINT16(1, feedLog.readRecent(out, 1, inNewest));
+    assertFeed(sectorStart[2] - 1, out[0]);
+
+    // Skipping everything leaves nothing
+    TEST_ASSERT_EQUAL_UINT16(0, feedLog.readRecent(out, 1, appended));
+}
+
+void test_full_log_erases_oldest_sector(void) {
+    uint8_t sectorCount = feedLog.getCapacityBytes() / FEED_LOG_SECTOR_SIZE;
+    fillSectors(sectorCount + 1);
+
+    // The first sector's feeds are gone, the second sector's are the oldest
+    FeedHistoryEntry out[3];
+    TEST_ASSERT_EQUAL_UINT16(1, feedLog.readRecent(out, 1, appended - 1 - sectorStart[1]));
+    assertFeed(sectorStart[1], out[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, feedLog.readRecent(out, 1, appended - sectorStart[1]));
+    TEST_ASSERT_EQUAL_UINT32(0, feedLog.sumGrams(feedAt(0).timestamp, feedAt(sectorStart[1]).timestamp));
+}
+
+void test_rotation_order_survives_reindex(void) {
+    uint8_t sectorCount = feedLog.getCapacityBytes() / FEED_LOG_SECTOR_SIZE;
+    fillSectors(sectorCount + 1);
+
+    // The reused first sector comes before the last one: order is by
+    // sequence number, not by position in the partition
+    TEST_ASSERT_TRUE(feedLog.begin());
+    uint32_t reused = sectorStart[sectorCount];
+    FeedHistoryEntry out[3];
+    TEST_ASSERT_EQUAL_UINT16(3, feedLog.readRecent(out, 3, appended - 1 - reused));
+    assertFeed(reused, out[0]);
+    assertFeed(reused - 1, out[1]);
+    assertFeed(reused - 2, out[2]);
+
+    // Appending continues the newest sector
+    uint32_t usedBefore = feedLog.getUsedBytes();
+    appendNext();
+    TEST_ASSERT_LESS_OR_EQUAL(usedBefore + FEED_RECORD_MAX_SIZE, feedLog.getUsedBytes());
+    TEST_ASSERT_EQUAL_UINT16(2, feedLog.readRecent(out, 2));
+    assertFeed(appended - 1, out[0]);
+    assertFeed(appended - 2, out[1]);
+}
+
+void test_torn_record_is_skipped(void) {
+    appendNext();
+    appendNext();
+
+    // Reset mid-write: all but the check byte programmed
+    uint8_t record[FEED_RECORD_MAX_SIZE];
+    uint8_t len = FeedRecord::encode(feedAt(appended), feedAt(appended - 1).timestamp, record);
+    const esp_partition_t *partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)FEED_LOG_PARTITION_SUBTYPE, FEED_LOG_PARTITION_LABEL);
+    TEST_ASSERT_NOT_NULL(partition);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(partition, feedLog.getUsedBytes(), record, len - 1));
+    appended++;
+
+    // After the reboot the next feed goes after the torn one, chained to
+    // the last good record
+    TEST_ASSERT_TRUE(feedLog.begin());
+    appendNext();
+
+    FeedHistoryEntry out[4];
+    TEST_ASSERT_EQUAL_UINT16(3, feedLog.readRecent(out, 4));
+    assertFeed(3, out[0]);
+    assertFeed(1, out[1]);
+    assertFeed(0, out[2]);
+}
+
+void test_sum_grams_by_day_across_sectors(void) {
+    fillSectors(4);
+    for (uint8_t i = 0; i < 30; i++) {
+        appendNext();
+    }
+
+    // Every day from before the first feed to after the last, so each
+    // sector boundary lands inside one of them
+    uint32_t firstDay = feedAt(0).timestamp / SECONDS_PER_DAY;
+    uint32_t lastDay = feedAt(appended - 1).timestamp / SECONDS_PER_DAY;
+    for (uint32_t day = firstDay - 1; day <= lastDay + 1; day++) {
+        uint32_t from = day * SECONDS_PER_DAY;
+        uint32_t to = from + SECONDS_PER_DAY;
+        uint32_t expected = 0;
+        for (uint32_t i = 0; i < appended; i++) {
+            FeedHistoryEntry entry = feedAt(i);
+            if (entry.timestamp >= from && entry.timestamp < to) expected += entry.grams;
+        }
+        TEST_ASSERT_EQUAL_UINT32(expected, feedLog.sumGrams(from, to));
+    }
+
+    // A range spanning a whole sector and parts of its neighbours
+    uint32_t from = feedAt(sectorStart[1] - 5).timestamp;
+    uint32_t to = feedAt(sectorStart[2] + 5).timestamp;
+    uint32_t expected = 0;
+    for (uint32_t i = sectorStart[1] - 5; i < sectorStart[2] + 5; i++) {
+        expected += feedAt(i).grams;
+    }
+    TEST_ASSERT_EQUAL_UINT32(expected, feedLog.sumGrams(from, to));
+}
+
+void setup() {
+    // Wait for serial monitor to connect before running tests
+    delay(2000);
+
+    logAvailable = feedLog.begin();
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_read_recent_skips_across_sectors);
+    RUN_TEST(test_full_log_erases_oldest_sector);
+    RUN_TEST(test_rotation_order_survives_reindex);
+    RUN_TEST(test_torn_record_is_skipped);
+    RUN_TEST(test_sum_grams_by_day_across_sectors);
+
+    UNITY_END();
+}
+
+void loop() {
+    delay(100);
+}
@@ -0,0 +1,198 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "FeedRecord.hpp"
+#include "ConfigService.hpp"
+
+ConfigService configService;
+
+static const uint32_t BASE_TIME = 1735689600;  // 2025-01-01 00:00:00 UTC
+
+// How firmware before the packed format stored the ring in "feedHist"
+struct LegacyFeedHistoryEntry {
+    uint32_t timestamp;
+    uint8_t portion_units;
+};
+
+// Encodes entry relative to previous, checks the length agrees with the
+// header, and returns the decoded copy
+FeedHistoryEntry roundTrip(const FeedHistoryEntry &entry, uint32_t previous) {
+    uint8_t record[FEED_RECORD_MAX_SIZE];
+    uint8_t len = FeedRecord::encode(entry, previous, record);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT8(FEED_RECORD_MIN_SIZE, len);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT8(FEED_RECORD_MAX_SIZE, len);
+    TEST_ASSERT_EQUAL_UINT8(len, FeedRecord::length(record[0]));
+    // Neither end of a record may look like erased flash
+    TEST_ASSERT_NOT_EQUAL(0xFF, record[0]);
+    TEST_ASSERT_NOT_EQUAL(0xFF, record[len - 1]);
+
+    FeedHistoryEntry decoded = {};
+    TEST_ASSERT_TRUE(FeedRecord::decode(record, previous, decoded));
+    return decoded;
+}
+
+void assertEntry(const FeedHistoryEntry &expected, const FeedHistoryEntry &actual) {
+    TEST_ASSERT_EQUAL_UINT32(expected.timestamp, actual.timestamp);
+    TEST_ASSERT_EQUAL_UINT16(expected.grams, actual.grams);
+    TEST_ASSERT_EQUAL_UINT8(expected.tag, actual.tag);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_positive_and_negative_deltas_round_trip(void) {
+    const int32_t deltas[] = {0, 1, -1, 63, -64, 3600, -3600, 86400 * 7, -86400 * 7};
+    for (int32_t delta : deltas) {
+        FeedHistoryEntry entry = {BASE_TIME + delta, 12, FEED_TAG_WEB};
+        assertEntry(entry, roundTrip(entry, BASE_TIME));
+    }
+}
+
+void test_grams_limits_round_trip(void) {
+    FeedHistoryEntry none = {BASE_TIME + 60, 0, FEED_TAG_BUTTON};
+    assertEntry(none, roundTrip(none, BASE_TIME));
+
+    FeedHistoryEntry most = {BASE_TIME + 60, 65535, FEED_TAG_BUTTON};
+    assertEntry(most, roundTrip(most, BASE_TIME));
+}
+
+void test_every_tag_round_trips(void) {
+    for (uint8_t tag = 0; tag <= FEED_TAG_MAX; tag++) {
+        FeedHistoryEntry entry = {BASE_TIME + 60, 24, tag};
+        assertEntry(entry, roundTrip(entry, BASE_TIME));
+    }
+
+    // Out of range is stored as unknown rather than spilling into the length
+    FeedHistoryEntry outOfRange = {BASE_TIME + 60, 24, FEED_TAG_MAX + 1};
+    TEST_ASSERT_EQUAL_UINT8(FEED_TAG_UNKNOWN, roundTrip(outOfRange, BASE_TIME).tag);
+}
+
+void test_largest_record_is_ten_bytes(void) {
+    // Five-byte delta (zigzag of INT32_MIN) plus three-byte grams
+    FeedHistoryEntry entry = {0, 65535, FEED_TAG_MAX};
+    uint8_t record[FEED_RECORD_MAX_SIZE];
+    TEST_ASSERT_EQUAL_UINT8(FEED_RECORD_MAX_SIZE, FeedRecord::encode(entry, 0x80000000UL, record));
+    assertEntry(entry, roundTrip(entry, 0x80000000UL));
+}
+
+void test_torn_record_fails_check(void) {
+    FeedHistoryEntry entry = {BASE_TIME + 3600, 12, FEED_TAG_SCHEDULE_ID(2)};
+    uint8_t record[FEED_RECORD_MAX_SIZE];
+    uint8_t len = FeedRecord::encode(entry, BASE_TIME, record);
+
+    // Reset before the check byte was programmed: still erased
+    record[len - 1] = 0xFF;
+    FeedHistoryEntry decoded;
+    TEST_ASSERT_FALSE(FeedRecord::decode(record, BASE_TIME, decoded));
+
+    // Erased flash is no header at all
+    TEST_ASSERT_EQUAL_UINT8(0, FeedRecord::length(0xFF));
+}
+
+void test_block_truncates_at_capacity(void) {
+    FeedHistoryEntry entries[MAX_FEED_HISTORY];
+    for (uint8_t i = 0; i < MAX_FEED_HISTORY; i++) {
+        entries[i] = {BASE_TIME + i * 3600, (uint16_t)(12 * (i + 1)), FEED_TAG_WEB};
+    }
+
+    uint8_t full[FEED_HISTORY_BLOB_SIZE];
+    size_t fullSize = FeedRecord::encodeBlock(entries, MAX_FEED_HISTORY, full, sizeof(full));
+
+    // One byte short of the whole block: the last record is left out
+    // entirely, never cut
+    uint8_t block[FEED_HISTORY_BLOB_SIZE];
+    size_t size = FeedRecord::encodeBlock(entries, MAX_FEED_HISTORY, block, fullSize - 1);
+    TEST_ASSERT_LESS_THAN(fullSize, size);
+    TEST_ASSERT_EQUAL_MEMORY(full, block, size);
+
+    FeedHistoryEntry decoded[MAX_FEED_HISTORY];
+    TEST_ASSERT_EQUAL_UINT16(MAX_FEED_HISTORY - 1, FeedRecord::decodeBlock(block, size, decoded, MAX_FEED_HISTORY));
+    for (uint8_t i = 0; i < MAX_FEED_HISTORY - 1; i++) {
+        assertEntry(entries[i], decoded[i]);
+    }
+
+    // Too small for even the base timestamp
+    TEST_ASSERT_EQUAL(0, FeedRecord::encodeBlock(entries, MAX_FEED_HISTORY, block, 3));
+}
+
+void test_block_decode_stops_at_bad_record(void) {
+    FeedHistoryEntry entries[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        entries[i] = {BASE_TIME + i * 3600, 12, FEED_TAG_BUTTON};
+    }
+    uint8_t block[FEED_HISTORY_BLOB_SIZE];
+    size_t size = FeedRecord::encodeBlock(entries, 4, block, sizeof(block));
+
+    // Corrupt the third record's check byte; the fourth would decode, but
+    // relative to a timestamp that can't be trusted
+    size_t pos = sizeof(uint32_t);
+    pos += FeedRecord::length(block[pos]);
+    pos += FeedRecord::length(block[pos]);
+    pos += FeedRecord::length(block[pos]) - 1;
+    block[pos] ^= 0x01;
+
+    FeedHistoryEntry decoded[4];
+    TEST_ASSERT_EQUAL_UINT16(2, FeedRecord::decodeBlock(block, size, decoded, 4));
+    assertEntry(entries[0], decoded[0]);
+    assertEntry(entries[1], decoded[1]);
+}
+
+void test_legacy_history_loads_as_grams(void) {
+    Preferences prefs;
+    prefs.begin("feeder", false);
+    prefs.clear();
+    LegacyFeedHistoryEntry legacy[3] = {
+        {BASE_TIME, 1},
+        {BASE_TIME + 3600, 2},
+        {BASE_TIME + 7200, 3},
+    };
+    prefs.putBytes("feedHist", legacy, sizeof(legacy));
+    prefs.putUChar("feedHistCnt", 3);
+    prefs.putUChar("feedHistIdx", 3);
+    prefs.end();
+
+    configService.begin();
+    configService.setPortionUnitGrams(15);
+
+    FeedHistoryEntry history[MAX_FEED_HISTORY];
+    uint8_t writeIndex = 0;
+    TEST_ASSERT_EQUAL_UINT8(3, configService.loadFeedHistory(history, MAX_FEED_HISTORY, writeIndex));
+    TEST_ASSERT_EQUAL_UINT8(3, writeIndex);
+    for (uint8_t i = 0; i < 3; i++) {
+        FeedHistoryEntry expected = {legacy[i].timestamp, (uint16_t)(legacy[i].portion_units * 15), FEED_TAG_UNKNOWN};
+        assertEntry(expected, history[i]);
+    }
+
+    // The next save replaces it with the packed block
+    TEST_ASSERT_TRUE(configService.saveFeedHistory(history, 3, writeIndex));
+    TEST_ASSERT_TRUE(configService.flush());
+    FeedHistoryEntry reloaded[MAX_FEED_HISTORY];
+    TEST_ASSERT_EQUAL_UINT8(3, configService.loadFeedHistory(reloaded, MAX_FEED_HISTORY, writeIndex));
+    for (uint8_t i = 0; i < 3; i++) {
+        assertEntry(history[i], reloaded[i]);
+    }
+}
+
+void setup() {
+    // Wait for serial monitor to connect before running tests
+    delay(2000);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_positive_and_negative_deltas_round_trip);
+    RUN_TEST(test_grams_limits_round_trip);
+    RUN_TEST(test_every_tag_round_trips);
+    RUN_TEST(test_largest_record_is_ten_bytes);
+    RUN_TEST(test_torn_record_fails_check);
+    RUN_TEST(test_block_truncates_at_capacity);
+    RUN_TEST(test_block_decode_stops_at_bad_record);
+    RUN_TEST(test_legacy_history_loads_as_grams);
+
+    UNITY_END();
+}
+
+void loop() {
+    delay(100);
+}
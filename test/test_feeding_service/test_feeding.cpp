@@ -0,0 +1,240 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "FeedingService.hpp"
+#include "LightBarrierService.hpp"
+#include "ConfigService.hpp"
+#include "ClockService.hpp"
+
+// The light barrier runs simulated: simulateBeam() takes the interrupt's
+// path, so FeedingService verifies portions exactly as with a sensor
+FeedingService feedingService;
+LightBarrierService lightBarrier;
+ConfigService configService;
+ClockService clockService;
+
+static const unsigned long FEED_TIMEOUT_MS = 20000;
+
+// One pellet falling through the beam
+void pellet() {
+    lightBarrier.simulateBeam(true);
+    delay(3);
+    lightBarrier.simulateBeam(false);
+    delay(3);
+}
+
+// Run the state machine until the gate is open for a portion
+bool runUntilOpen() {
+    unsigned long start = millis();
+    while (millis() - start < FEED_TIMEOUT_MS) {
+        feedingService.update();
+        if (feedingService.getPosition() == configService.getServoOpenAngle()) return true;
+        delay(1);
+    }
+    return false;
+}
+
+// Run the state machine until the feed is over and the servos are off
+bool runUntilIdle() {
+    unsigned long start = millis();
+    while (millis() - start < FEED_TIMEOUT_MS) {
+        feedingService.update();
+        if (!feedingService.isFeeding()) return true;
+        delay(1);
+    }
+    return false;
+}
+
+void setUp(void) {
+    lightBarrier.simulateBeam(false);
+    configService.setServoAngles(DEFAULT_SERVO_CLOSE_ANGLE, DEFAULT_SERVO_OPEN_ANGLE);
+    configService.setBarrierPulsesPerPortion(3);
+    configService.setOpenDwellMs(3000);
+    configService.setPortionGapMs(DEFAULT_PORTION_GAP_MS);
+}
+
+void tearDown(void) {
+    lightBarrier.simulateBeam(false);
+    runUntilIdle();
+}
+
+void test_full_portion_closes_before_the_dwell(void) {
+    const DispenseStats before = feedingService.getDispenseStats();
+    feedingService.feed(1, FEED_SOURCE_WEB);
+    TEST_ASSERT_TRUE(runUntilOpen());
+
+    pellet();
+    pellet();
+    pellet();
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    const DispenseStats &after = feedingService.getDispenseStats();
+    TEST_ASSERT_EQUAL_UINT32(before.earlyCloses + 1, after.earlyCloses);
+    TEST_ASSERT_EQUAL_UINT32(before.verifiedPortions + 1, after.verifiedPortions);
+    TEST_ASSERT_EQUAL_UINT16(3, after.lastPulses);
+    TEST_ASSERT_EQUAL(DISPENSE_OK, after.lastFault);
+    // Open and closed again well inside the 3 s dwell
+    TEST_ASSERT_LESS_THAN_UINT32(3000, feedingService.getCycleStats().lastCycleMs);
+}
+
+void test_feed_amount_reached_skips_remaining_portions(void) {
+    const DispenseStats before = feedingService.getDispenseStats();
+    feedingService.feed(3, FEED_SOURCE_WEB);
+    TEST_ASSERT_TRUE(runUntilOpen());
+
+    for (uint8_t i = 0; i < 9; i++) {
+        pellet();
+    }
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    TEST_ASSERT_EQUAL_UINT32(before.earlyFeedEnds + 1, feedingService.getDispenseStats().earlyFeedEnds);
+    TEST_ASSERT_EQUAL_UINT8(1, feedingService.getCycleStats().lastSequencePortions);
+}
+
+void test_blocked_beam_aborts_feed_as_jam(void) {
+    feedingService.feed(3, FEED_SOURCE_WEB);
+    TEST_ASSERT_TRUE(runUntilOpen());
+
+    // Stays blocked past LIGHT_BARRIER_JAM_MS while the gate is open
+    lightBarrier.simulateBeam(true);
+    TEST_ASSERT_TRUE(runUntilIdle());
+    lightBarrier.simulateBeam(false);
+
+    TEST_ASSERT_EQUAL(DISPENSE_JAM, feedingService.getDispenseStats().lastFault);
+    TEST_ASSERT_EQUAL_UINT8(1, feedingService.getCycleStats().lastSequencePortions);
+}
+
+void test_empty_hopper_ends_feed(void) {
+    configService.setOpenDwellMs(500);
+    const DispenseStats before = feedingService.getDispenseStats();
+    feedingService.feed(5, FEED_SOURCE_WEB);
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    const DispenseStats &after = feedingService.getDispenseStats();
+    TEST_ASSERT_EQUAL(DISPENSE_EMPTY, after.lastFault);
+    TEST_ASSERT_EQUAL_UINT32(before.emptyPortions + LIGHT_BARRIER_EMPTY_PORTIONS, after.emptyPortions);
+    TEST_ASSERT_EQUAL_UINT8(LIGHT_BARRIER_EMPTY_PORTIONS, feedingService.getCycleStats().lastSequencePortions);
+}
+
+void test_zero_pulses_per_portion_only_counts(void) {
+    configService.setBarrierPulsesPerPortion(0);
+    configService.setOpenDwellMs(500);
+    const DispenseStats before = feedingService.getDispenseStats();
+    feedingService.feed(1, FEED_SOURCE_WEB);
+    TEST_ASSERT_TRUE(runUntilOpen());
+
+    for (uint8_t i = 0; i < 5; i++) {
+        pellet();
+    }
+    TEST_ASSERT_TRUE(runUntilIdle());
+
+    const DispenseStats &after = feedingService.getDispenseStats();
+    TEST_ASSERT_EQUAL_UINT16(5, after.lastPulses);
+    TEST_ASSERT_EQUAL_UINT32(before.earlyCloses, after.earlyCloses);
+    TEST_ASSERT_EQUAL_UINT32(before.verifiedPortions, after.verifiedPortions);
+    TEST_ASSERT_EQUAL_UINT32(before.shortPortions, after.shortPortions);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(500, feedingService.getCycleStats().lastCycleMs);
+}
+
+void test_servos_stay_attached_between_portions(void) {
+    const uint8_t portions = 4;
+    configService.setBarrierPulsesPerPortion(0);
+    feedingService.feed(portions, FEED_SOURCE_WEB);
+
+    // One pellet per opening, so the hopper never reads as empty
+    bool dropped = false;
+    unsigned long start = millis();
+    while (feedingService.isFeeding() && millis() - start < FEED_TIMEOUT_MS) {
+        feedingService.update();
+        bool open = feedingService.getPosition() == configService.getServoOpenAngle();
+        if (open && !dropped) pellet();
+        dropped = open;
+        delay(1);
+    }
+    TEST_ASSERT_FALSE(feedingService.isFeeding());
+
+    // One power-up for the whole feed (no VibrationService here, so no
+    // pre-agitation), then only open, dwell, close and gap per portion;
+    // a power cycle per move would add 2 * SERVO_POWER_UP_TIME to each
+    const FeedCycleStats &stats = feedingService.getCycleStats();
+    TEST_ASSERT_EQUAL_UINT8(portions, stats.lastSequencePortions);
+    uint32_t bound = SERVO_POWER_UP_TIME + portions * (stats.maxCycleMs + configService.getPortionGapMs() + 20);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(bound, stats.lastSequenceMs);
+}
+
+void test_requested_feed_starts_on_next_update(void) {
+    configService.setOpenDwellMs(200);
+    feedingService.requestFeed(2, FEED_SOURCE_WEB);
+    feedingService.requestFeed(1, FEED_SOURCE_WEB);
+
+    // Counts as feeding before the loop took it, so nothing sleeps on it
+    TEST_ASSERT_TRUE(feedingService.isFeeding());
+    TEST_ASSERT_EQUAL_UINT8(0, feedingService.getQueueDepth());
+
+    // Both requests folded into one feed of the larger count
+    TEST_ASSERT_TRUE(runUntilIdle());
+    TEST_ASSERT_EQUAL_UINT8(2, feedingService.getCycleStats().lastSequencePortions);
+}
+
+void test_history_skip_past_the_ring_reads_nothing(void) {
+    FeedHistoryEntry ring[3] = {
+        {1735689600, 12, FEED_TAG_WEB},
+        {1735693200, 24, FEED_TAG_BUTTON},
+        {1735696800, 12, FEED_TAG_WEB},
+    };
+    feedingService.loadFeedHistory(ring, 3, 3);
+
+    FeedHistoryEntry out[MAX_FEED_HISTORY];
+    TEST_ASSERT_EQUAL_UINT16(1, feedingService.readFeedHistory(out, MAX_FEED_HISTORY, 2));
+    TEST_ASSERT_EQUAL_UINT32(ring[0].timestamp, out[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT16(0, feedingService.readFeedHistory(out, MAX_FEED_HISTORY, 3));
+    // An offset that wraps an 8-bit index must not start over
+    TEST_ASSERT_EQUAL_UINT16(0, feedingService.readFeedHistory(out, MAX_FEED_HISTORY, 256));
+}
+
+void test_jammed_feed_records_only_dispensed_portions(void) {
+    if (!clockService.isAvailable()) {
+        TEST_IGNORE_MESSAGE("No DS3231 on this board - feeds are not timestamped");
+    }
+
+    feedingService.feed(3, FEED_SOURCE_BUTTON);
+    TEST_ASSERT_TRUE(runUntilOpen());
+    lightBarrier.simulateBeam(true);
+    TEST_ASSERT_TRUE(runUntilIdle());
+    lightBarrier.simulateBeam(false);
+
+    FeedHistoryEntry newest;
+    TEST_ASSERT_EQUAL_UINT16(1, feedingService.readFeedHistory(&newest, 1));
+    TEST_ASSERT_EQUAL_UINT16(configService.getPortionUnitGrams(), newest.grams);
+    TEST_ASSERT_EQUAL_UINT8(FEED_TAG_BUTTON, newest.tag);
+}
+
+void setup() {
+    // Wait for serial monitor to connect before running tests
+    delay(2000);
+
+    configService.begin();
+    clockService.begin();
+    lightBarrier.beginSimulated();
+    feedingService.setConfigService(&configService);
+    feedingService.setClockService(&clockService);
+    feedingService.setLightBarrierService(&lightBarrier);
+    feedingService.setup();
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_full_portion_closes_before_the_dwell);
+    RUN_TEST(test_feed_amount_reached_skips_remaining_portions);
+    RUN_TEST(test_blocked_beam_aborts_feed_as_jam);
+    RUN_TEST(test_empty_hopper_ends_feed);
+    RUN_TEST(test_zero_pulses_per_portion_only_counts);
+    RUN_TEST(test_servos_stay_attached_between_portions);
+    RUN_TEST(test_requested_feed_starts_on_next_update);
+    RUN_TEST(test_history_skip_past_the_ring_reads_nothing);
+    RUN_TEST(test_jammed_feed_records_only_dispensed_portions);
+
+    UNITY_END();
+}
+
+void loop() {
+    delay(100);
+}
@@ -0,0 +1,92 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "LightBarrierService.hpp"
+
+// No sensor needed: simulateBeam() runs the same edge handling as the
+// GPIO interrupt
+LightBarrierService lightBarrier;
+
+// One pellet falling through the beam
+void pellet() {
+    lightBarrier.simulateBeam(true);
+    delay(3);
+    lightBarrier.simulateBeam(false);
+    delay(3);
+}
+
+void setUp(void) {
+    lightBarrier.simulateBeam(false);
+    lightBarrier.arm();
+}
+
+void tearDown(void) {
+    lightBarrier.disarm();
+}
+
+void test_counts_each_interruption_while_armed(void) {
+    pellet();
+    pellet();
+    pellet();
+    TEST_ASSERT_EQUAL_UINT32(3, lightBarrier.getPulseCount());
+}
+
+void test_ignores_interruptions_while_disarmed(void) {
+    pellet();
+    lightBarrier.disarm();
+    pellet();
+    TEST_ASSERT_EQUAL_UINT32(1, lightBarrier.getPulseCount());
+}
+
+void test_arm_resets_count(void) {
+    pellet();
+    lightBarrier.arm();
+    TEST_ASSERT_EQUAL_UINT32(0, lightBarrier.getPulseCount());
+}
+
+void test_bounce_within_debounce_counts_once(void) {
+    lightBarrier.simulateBeam(true);
+    lightBarrier.simulateBeam(false);
+    lightBarrier.simulateBeam(true);
+    lightBarrier.simulateBeam(false);
+    TEST_ASSERT_EQUAL_UINT32(1, lightBarrier.getPulseCount());
+}
+
+void test_repeated_level_is_not_an_edge(void) {
+    delay(3);
+    lightBarrier.simulateBeam(true);
+    delay(3);
+    lightBarrier.simulateBeam(true);
+    TEST_ASSERT_EQUAL_UINT32(1, lightBarrier.getPulseCount());
+}
+
+void test_blocked_beam_reports_jam(void) {
+    lightBarrier.simulateBeam(true);
+    TEST_ASSERT_TRUE(lightBarrier.isBlocked());
+    TEST_ASSERT_FALSE(lightBarrier.isJammed());
+
+    delay(LIGHT_BARRIER_JAM_MS + 50);
+    TEST_ASSERT_TRUE(lightBarrier.isJammed());
+
+    lightBarrier.simulateBeam(false);
+    TEST_ASSERT_FALSE(lightBarrier.isJammed());
+}
+
+void setup() {
+    // Wait for serial monitor to connect before running tests
+    delay(2000);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_counts_each_interruption_while_armed);
+    RUN_TEST(test_ignores_interruptions_while_disarmed);
+    RUN_TEST(test_arm_resets_count);
+    RUN_TEST(test_bounce_within_debounce_counts_once);
+    RUN_TEST(test_repeated_level_is_not_an_edge);
+    RUN_TEST(test_blocked_beam_reports_jam);
+
+    UNITY_END();
+}
+
+void loop() {
+    delay(100);
+}
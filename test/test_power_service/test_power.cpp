@@ -0,0 +1,70 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "PowerService.hpp"
+
+PowerService powerService;
+
+void setUp(void) {
+    powerService.cancelSleep();
+}
+
+void tearDown(void) {
+}
+
+void test_no_request_never_sleeps(void) {
+    TEST_ASSERT_NULL(powerService.update(false));
+    TEST_ASSERT_FALSE(powerService.isSleepRequested());
+}
+
+void test_request_while_idle_sleeps_at_once(void) {
+    powerService.requestSleep("Manual long press");
+    TEST_ASSERT_EQUAL_STRING("Manual long press", powerService.update(false));
+    TEST_ASSERT_FALSE(powerService.isSleepRequested());
+}
+
+void test_request_during_held_feed_waits_until_idle(void) {
+    // Long press while the scheduler holds a feed for its target second:
+    // sleeping now would skip it, the next alarm is for the batch after
+    powerService.requestSleep("Manual long press");
+    for (uint8_t i = 0; i < 10; i++) {
+        TEST_ASSERT_NULL(powerService.update(true));
+    }
+    TEST_ASSERT_TRUE(powerService.isSleepRequested());
+
+    // Hold released and the feed has run
+    TEST_ASSERT_EQUAL_STRING("Manual long press", powerService.update(false));
+    TEST_ASSERT_NULL(powerService.update(false));
+}
+
+void test_later_request_replaces_reason(void) {
+    powerService.requestSleep("Remote request");
+    TEST_ASSERT_NULL(powerService.update(true));
+    powerService.requestSleep("Manual long press");
+    TEST_ASSERT_EQUAL_STRING("Manual long press", powerService.update(false));
+}
+
+void test_cancel_drops_deferred_request(void) {
+    powerService.requestSleep("Remote request");
+    TEST_ASSERT_NULL(powerService.update(true));
+    powerService.cancelSleep();
+    TEST_ASSERT_NULL(powerService.update(false));
+}
+
+void setup() {
+    // Wait for serial monitor to connect before running tests
+    delay(2000);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_no_request_never_sleeps);
+    RUN_TEST(test_request_while_idle_sleeps_at_once);
+    RUN_TEST(test_request_during_held_feed_waits_until_idle);
+    RUN_TEST(test_later_request_replaces_reason);
+    RUN_TEST(test_cancel_drops_deferred_request);
+
+    UNITY_END();
+}
+
+void loop() {
+    delay(100);
+}
@@ -0,0 +1,77 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "TimeZone.hpp"
+// See test_vibration_service - keeps `pio test`'s LDF resolving RTClib's deps
+#include "ClockService.hpp"
+
+TimeZone tz;
+
+void setUp(void) {
+    tz.set(DEFAULT_TIME_ZONE);
+}
+
+void tearDown(void) {
+}
+
+void test_berlin_offsets_around_transitions(void) {
+    // 2025: CEST from 2025-03-30 01:00 UTC until 2025-10-26 01:00 UTC
+    TEST_ASSERT_EQUAL_INT32(3600, tz.utcOffsetForUtc(DateTime(2025, 3, 30, 0, 59, 59).unixtime()));
+    TEST_ASSERT_EQUAL_INT32(7200, tz.utcOffsetForUtc(DateTime(2025, 3, 30, 1, 0, 0).unixtime()));
+    TEST_ASSERT_EQUAL_INT32(7200, tz.utcOffsetForUtc(DateTime(2025, 10, 26, 0, 59, 59).unixtime()));
+    TEST_ASSERT_EQUAL_INT32(3600, tz.utcOffsetForUtc(DateTime(2025, 10, 26, 1, 0, 0).unixtime()));
+    TEST_ASSERT_EQUAL_STRING("CEST", tz.getName(tz.isDstUtc(DateTime(2025, 7, 1, 12, 0, 0).unixtime())));
+}
+
+void test_berlin_local_wall_clock(void) {
+    // Skipped spring hour counts as standard time, repeated autumn hour as DST
+    TEST_ASSERT_FALSE(tz.isDstLocal(DateTime(2025, 3, 30, 2, 30, 0).unixtime()));
+    TEST_ASSERT_TRUE(tz.isDstLocal(DateTime(2025, 3, 30, 3, 0, 0).unixtime()));
+    TEST_ASSERT_TRUE(tz.isDstLocal(DateTime(2025, 10, 26, 2, 59, 59).unixtime()));
+    TEST_ASSERT_FALSE(tz.isDstLocal(DateTime(2025, 10, 26, 3, 0, 0).unixtime()));
+}
+
+void test_other_zones(void) {
+    // US Eastern: second Sunday in March to first Sunday in November
+    TEST_ASSERT_TRUE(tz.set("EST5EDT,M3.2.0,M11.1.0"));
+    TEST_ASSERT_EQUAL_INT32(-18000, tz.utcOffsetForUtc(DateTime(2025, 3, 9, 6, 59, 0).unixtime()));
+    TEST_ASSERT_EQUAL_INT32(-14400, tz.utcOffsetForUtc(DateTime(2025, 3, 9, 7, 0, 0).unixtime()));
+
+    // Southern hemisphere: DST spans the new year
+    TEST_ASSERT_TRUE(tz.set("AEST-10AEDT,M10.1.0,M4.1.0/3"));
+    TEST_ASSERT_EQUAL_INT32(39600, tz.utcOffsetForUtc(DateTime(2025, 1, 15, 0, 0, 0).unixtime()));
+    TEST_ASSERT_EQUAL_INT32(36000, tz.utcOffsetForUtc(DateTime(2025, 7, 15, 0, 0, 0).unixtime()));
+
+    // No DST, quoted name, half-hour offset
+    TEST_ASSERT_TRUE(tz.set("<+0530>-5:30"));
+    TEST_ASSERT_EQUAL_INT32(19800, tz.utcOffsetForUtc(DateTime(2025, 7, 15, 0, 0, 0).unixtime()));
+}
+
+void test_invalid_rules_are_rejected(void) {
+    TEST_ASSERT_FALSE(TimeZone::isValid(""));
+    TEST_ASSERT_FALSE(TimeZone::isValid("CET"));
+    TEST_ASSERT_FALSE(TimeZone::isValid("CET-1CEST"));          // No transition rule
+    TEST_ASSERT_FALSE(TimeZone::isValid("CET-1CEST,J60,J300"));  // Only Mm.w.d supported
+    TEST_ASSERT_FALSE(TimeZone::isValid("CET-1CEST,M13.5.0,M10.5.0"));
+
+    // A rejected rule leaves the current one in place
+    TEST_ASSERT_FALSE(tz.set("bogus"));
+    TEST_ASSERT_EQUAL_STRING(DEFAULT_TIME_ZONE, tz.getRule());
+}
+
+void setup() {
+    // Wait for serial monitor to connect before running tests
+    delay(2000);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_berlin_offsets_around_transitions);
+    RUN_TEST(test_berlin_local_wall_clock);
+    RUN_TEST(test_other_zones);
+    RUN_TEST(test_invalid_rules_are_rejected);
+
+    UNITY_END();
+}
+
+void loop() {
+    delay(100);
+}
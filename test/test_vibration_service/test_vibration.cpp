@@ -10,6 +10,18 @@
 
 VibrationService vibrationService;
 
+// Duty follows millis() to the millisecond; allow a couple of ms of jitter
+#define DUTY_TOLERANCE 6
+
+// Update at `atMs` after `startMs` and return the duty written to LEDC
+uint32_t dutyAt(unsigned long startMs, unsigned long atMs) {
+    while (millis() - startMs < atMs) {
+        delay(1);
+    }
+    vibrationService.update();
+    return vibrationService.getDuty();
+}
+
 void setUp(void) {
     // Make sure every test starts from an off/idle state
     vibrationService.endFeedShake(0);
@@ -67,6 +79,59 @@ void test_trigger_pulse_is_noop_while_feed_shake_forced(void) {
     TEST_ASSERT_FALSE(vibrationService.isActive());
 }
 
+void test_soft_start_ramps_duty_to_full(void) {
+    if (!VibrationService::isCompiledIn()) TEST_IGNORE_MESSAGE("VIBRATION_MOTOR_ENABLED=0");
+
+    unsigned long start = millis();
+    vibrationService.startFeedShake(VIBRATION_STEADY);
+    TEST_ASSERT_UINT32_WITHIN(DUTY_TOLERANCE, 0, vibrationService.getDuty());
+    TEST_ASSERT_UINT32_WITHIN(DUTY_TOLERANCE, VIBRATION_MAX_DUTY / 3, dutyAt(start, VIBRATION_SOFT_START_MS / 3));
+    TEST_ASSERT_UINT32_WITHIN(DUTY_TOLERANCE, VIBRATION_MAX_DUTY * 2 / 3, dutyAt(start, VIBRATION_SOFT_START_MS * 2 / 3));
+    TEST_ASSERT_EQUAL_UINT32(VIBRATION_MAX_DUTY, dutyAt(start, VIBRATION_SOFT_START_MS + 10));
+    TEST_ASSERT_EQUAL_UINT32(VIBRATION_MAX_DUTY, dutyAt(start, VIBRATION_SOFT_START_MS + 200));
+}
+
+void test_pulses_pattern_is_150_on_100_off(void) {
+    if (!VibrationService::isCompiledIn()) TEST_IGNORE_MESSAGE("VIBRATION_MOTOR_ENABLED=0");
+
+    const unsigned long period = VIBRATION_PULSE_ON_MS + VIBRATION_PULSE_OFF_MS;
+    unsigned long start = millis();
+    vibrationService.startFeedShake(VIBRATION_PULSES);
+
+    // First pulse still soft-starting, its off time is off all the same
+    TEST_ASSERT_UINT32_WITHIN(DUTY_TOLERANCE, VIBRATION_MAX_DUTY / 3, dutyAt(start, 100));
+    TEST_ASSERT_EQUAL_UINT32(0, dutyAt(start, VIBRATION_PULSE_ON_MS + 20));
+
+    // Past the soft start: full on for 150 ms, off for 100 ms
+    for (unsigned long cycle = 2; cycle < 5; cycle++) {
+        TEST_ASSERT_EQUAL_UINT32(VIBRATION_MAX_DUTY, dutyAt(start, cycle * period + 10));
+        TEST_ASSERT_EQUAL_UINT32(VIBRATION_MAX_DUTY, dutyAt(start, cycle * period + VIBRATION_PULSE_ON_MS - 10));
+        TEST_ASSERT_EQUAL_UINT32(0, dutyAt(start, cycle * period + VIBRATION_PULSE_ON_MS + 10));
+        TEST_ASSERT_EQUAL_UINT32(0, dutyAt(start, (cycle + 1) * period - 10));
+    }
+}
+
+void test_ramp_pattern_never_drops_below_floor(void) {
+    if (!VibrationService::isCompiledIn()) TEST_IGNORE_MESSAGE("VIBRATION_MOTOR_ENABLED=0");
+
+    const uint32_t floor = VIBRATION_MAX_DUTY * VIBRATION_RAMP_MIN_PERCENT / 100;
+    const unsigned long half = VIBRATION_RAMP_PERIOD_MS / 2;
+    unsigned long start = millis();
+    vibrationService.startFeedShake(VIBRATION_RAMP);
+
+    // Triangle: at the floor at the start of each period, full halfway
+    TEST_ASSERT_UINT32_WITHIN(DUTY_TOLERANCE, floor, dutyAt(start, VIBRATION_RAMP_PERIOD_MS));
+    TEST_ASSERT_UINT32_WITHIN(DUTY_TOLERANCE, (floor + VIBRATION_MAX_DUTY) / 2,
+                              dutyAt(start, VIBRATION_RAMP_PERIOD_MS + half / 2));
+    TEST_ASSERT_UINT32_WITHIN(DUTY_TOLERANCE, VIBRATION_MAX_DUTY, dutyAt(start, VIBRATION_RAMP_PERIOD_MS + half));
+    TEST_ASSERT_UINT32_WITHIN(DUTY_TOLERANCE, floor, dutyAt(start, 2 * VIBRATION_RAMP_PERIOD_MS));
+
+    // Sampled over another full period, never below the floor
+    for (unsigned long at = 2 * VIBRATION_RAMP_PERIOD_MS; at < 3 * VIBRATION_RAMP_PERIOD_MS; at += 20) {
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(floor, dutyAt(start, at));
+    }
+}
+
 void setup() {
     // Wait for serial monitor to connect before running tests
     delay(2000);
@@ -79,6 +144,9 @@ void setup() {
     RUN_TEST(test_end_feed_shake_with_tail_stays_active_until_elapsed);
     RUN_TEST(test_trigger_pulse_turns_on_and_auto_off_after_duration);
     RUN_TEST(test_trigger_pulse_is_noop_while_feed_shake_forced);
+    RUN_TEST(test_soft_start_ramps_duty_to_full);
+    RUN_TEST(test_pulses_pattern_is_150_on_100_off);
+    RUN_TEST(test_ramp_pattern_never_drops_below_floor);
 
     UNITY_END();
 }
@@ -0,0 +1,107 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "WeekSchedule.hpp"
+// See test_vibration_service - keeps `pio test`'s LDF resolving RTClib's deps
+#include "ClockService.hpp"
+
+WeekSchedule week;
+Schedule schedules[MAX_SCHEDULES];
+
+void setUp(void) {
+    // Every slot disabled by default
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        schedules[i] = {(uint8_t)(i + 1), false, "00:00", 0, 1};
+    }
+    week.clear();
+}
+
+void tearDown(void) {
+}
+
+void test_empty_week_has_no_next(void) {
+    week.compile(schedules);
+    TEST_ASSERT_TRUE(week.isEmpty());
+    TEST_ASSERT_EQUAL_INT32(-1, week.minutesUntilNext(0));
+}
+
+void test_compile_sets_one_bit_per_weekday(void) {
+    schedules[0] = {1, true, "06:30", 0b00111110, 2}; // Mo-Fr
+    week.compile(schedules);
+
+    TEST_ASSERT_EQUAL(5, week.slotCount);
+    TEST_ASSERT_FALSE(week.isDue(0 * MINUTES_PER_DAY + 390));  // Sunday
+    TEST_ASSERT_TRUE(week.isDue(1 * MINUTES_PER_DAY + 390));   // Monday
+    TEST_ASSERT_FALSE(week.isDue(1 * MINUTES_PER_DAY + 391));
+
+    const WeekSlot* slot = week.slotAt(1 * MINUTES_PER_DAY + 390);
+    TEST_ASSERT_NOT_NULL(slot);
+    TEST_ASSERT_EQUAL(1, slot->scheduleId);
+    TEST_ASSERT_EQUAL(2, slot->portionUnits);
+}
+
+void test_next_wraps_around_week(void) {
+    schedules[0] = {1, true, "00:05", 0b00000001, 1}; // Sunday 00:05
+    week.compile(schedules);
+
+    // Saturday 23:59 -> Sunday 00:05 is six minutes ahead
+    TEST_ASSERT_EQUAL_INT32(6, week.minutesUntilNext(MINUTES_PER_WEEK - 1));
+    // The set minute itself is zero minutes ahead
+    TEST_ASSERT_EQUAL_INT32(0, week.minutesUntilNext(5));
+    // One minute later the next hit is a full week away
+    TEST_ASSERT_EQUAL_INT32(MINUTES_PER_WEEK - 1, week.minutesUntilNext(6));
+}
+
+void test_overlapping_schedules_are_merged_and_reported(void) {
+    schedules[0] = {1, true, "12:00", 0b01111111, 3};
+    schedules[1] = {2, true, "12:00", 0b00000010, 4}; // Monday only
+    uint8_t overlaps = week.compile(schedules);
+
+    TEST_ASSERT_EQUAL(1, overlaps);
+    TEST_ASSERT_EQUAL(7, week.slotCount);
+    TEST_ASSERT_EQUAL(1, week.overlaps[0].firstId);
+    TEST_ASSERT_EQUAL(2, week.overlaps[0].secondId);
+
+    const WeekSlot* slot = week.slotAt(1 * MINUTES_PER_DAY + 720);
+    TEST_ASSERT_NOT_NULL(slot);
+    TEST_ASSERT_EQUAL(7, slot->portionUnits);
+}
+
+void test_compile_shifts_local_times_to_utc(void) {
+    schedules[0] = {1, true, "00:30", 0b00000001, 1}; // Sunday 00:30 local
+    week.compile(schedules, 60);                       // UTC+1
+
+    // Lands on Saturday 23:30 UTC - across the week boundary
+    TEST_ASSERT_TRUE(week.isDue(MINUTES_PER_WEEK - 30));
+    TEST_ASSERT_FALSE(week.isDue(30));
+
+    // West of UTC moves it forward instead
+    week.compile(schedules, -300);
+    TEST_ASSERT_TRUE(week.isDue(330));
+}
+
+void test_minute_of_week_from_unix_time(void) {
+    // 2025-01-05 was a Sunday
+    TEST_ASSERT_EQUAL(0, WeekSchedule::minuteOfWeek(DateTime(2025, 1, 5, 0, 0, 0).unixtime()));
+    TEST_ASSERT_EQUAL(1 * MINUTES_PER_DAY + 390,
+                      WeekSchedule::minuteOfWeek(DateTime(2025, 1, 6, 6, 30, 45).unixtime()));
+}
+
+void setup() {
+    // Wait for serial monitor to connect before running tests
+    delay(2000);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_empty_week_has_no_next);
+    RUN_TEST(test_compile_sets_one_bit_per_weekday);
+    RUN_TEST(test_next_wraps_around_week);
+    RUN_TEST(test_overlapping_schedules_are_merged_and_reported);
+    RUN_TEST(test_compile_shifts_local_times_to_utc);
+    RUN_TEST(test_minute_of_week_from_unix_time);
+
+    UNITY_END();
+}
+
+void loop() {
+    delay(100);
+}
@@ -33,6 +33,8 @@ class MockAPI {
             version: 1,
             portion_unit_grams: 12,
             manual_portion_units: 1,
+            batch_window_minutes: 0,
+            timezone: 'CET-1CEST,M3.5.0,M10.5.0/3',
             vibration_available: true,
             vibration_enabled: true,
             vibration_pulse_seconds: 3,
@@ -55,6 +57,8 @@ class MockAPI {
             version: 1,
             portion_unit_grams: 12,
             manual_portion_units: 1,
+            batch_window_minutes: 0,
+            timezone: 'CET-1CEST,M3.5.0,M10.5.0/3',
             vibration_available: true,
             vibration_enabled: true,
             vibration_pulse_seconds: 3,
@@ -76,6 +80,14 @@ class MockAPI {
             normalized.manual_portion_units = 1;
         }
 
+        if (!Number.isInteger(normalized.batch_window_minutes) || normalized.batch_window_minutes < 0 || normalized.batch_window_minutes > 30) {
+            normalized.batch_window_minutes = 0;
+        }
+
+        if (typeof normalized.timezone !== 'string' || normalized.timezone.length === 0 || normalized.timezone.length > 48) {
+            normalized.timezone = 'CET-1CEST,M3.5.0,M10.5.0/3';
+        }
+
         if (!Number.isInteger(normalized.vibration_pulse_seconds) || normalized.vibration_pulse_seconds < 1 || normalized.vibration_pulse_seconds > 30) {
             normalized.vibration_pulse_seconds = 3;
         }
@@ -263,6 +275,8 @@ class MockAPI {
             version: 1,
             portion_unit_grams: 12,
             manual_portion_units: 1,
+            batch_window_minutes: 0,
+            timezone: 'CET-1CEST,M3.5.0,M10.5.0/3',
             vibration_available: true,
             vibration_enabled: true,
             vibration_pulse_seconds: 3,
@@ -66,6 +66,8 @@ export class ChickenFeederApp {
         this.elements.portionUnitInput = document.getElementById('portionUnitInput');
         this.elements.manualPortionSlider = document.getElementById('manualPortionSlider');
         this.elements.manualPortionDisplay = document.getElementById('manualPortionDisplay');
+        this.elements.batchWindowInput = document.getElementById('batchWindowInput');
+        this.elements.timezoneInput = document.getElementById('timezoneInput');
         this.elements.uiVersion = document.getElementById('uiVersion');
 
         // Vibration motor elements
@@ -145,6 +147,10 @@ export class ChickenFeederApp {
         }
 
         // Vibration motor settings
+        if (this.elements.batchWindowInput) {
+            this.elements.batchWindowInput.addEventListener('change', () => this.updateBatchWindow());
+        }
+
         if (this.elements.vibrationEnabledToggle) {
             this.elements.vibrationEnabledToggle.addEventListener('change', () => this.updateVibrationSetting());
         }
@@ -366,17 +372,36 @@ export class ChickenFeederApp {
 
     async syncTime() {
         try {
-            // Get current browser time as UTC Unix timestamp
-            const unixTime = Math.floor(Date.now() / 1000);
-
             if (this.useMock) {
+                // Get current browser time as UTC Unix timestamp
+                const unixTime = Math.floor(Date.now() / 1000);
                 if (!await this.ensureMockReady()) throw new Error('Mock API unavailable');
                 return await this.mockApi.syncTime(unixTime);
             }
 
+            // NTP-style exchange: keep the echo with the shortest round trip,
+            // its midpoint is the most accurate
+            let best = null;
+            for (let i = 0; i < 3; i++) {
+                const t0 = Date.now();
+                const echo = await this.apiRequest('/time/echo');
+                const t3 = Date.now();
+                if (!echo.success || !echo.data) continue;
+
+                const roundTrip = (t3 - t0) - (echo.data.t2 - echo.data.t1) / 1000;
+                if (!best || roundTrip < best.roundTrip) {
+                    best = { t0, t1: echo.data.t1, t2: echo.data.t2, t3, roundTrip };
+                }
+            }
+            if (!best) {
+                console.error('[TIME] Time echo failed');
+                return false;
+            }
+
+            const { t0, t1, t2, t3 } = best;
             const response = await this.apiRequest('/time', {
                 method: 'POST',
-                body: JSON.stringify({ unixTime })
+                body: JSON.stringify({ t0, t1, t2, t3 })
             });
 
             if (!response.success) {
@@ -384,7 +409,21 @@ export class ChickenFeederApp {
                 return false;
             }
 
-            console.log('[TIME] Time synchronized successfully');
+            // The RTC is written on a later second boundary, and only once no
+            // feed is running - wait for the outcome before reading the clock
+            let sync = 'pending';
+            for (let i = 0; i < 20 && sync === 'pending'; i++) {
+                await new Promise(resolve => setTimeout(resolve, 500));
+                const time = await this.getTime();
+                sync = time.data?.sync ?? 'done';
+            }
+            if (sync === 'failed') {
+                console.error('[TIME] Device could not apply the time sync');
+                this.showToast('Time sync failed', 'error');
+                return false;
+            }
+
+            console.log(sync === 'pending' ? '[TIME] Time sync still pending' : '[TIME] Time synchronized successfully');
             return true;
         } catch (error) {
             console.error('[TIME] Time sync error:', error);
@@ -615,6 +654,14 @@ export class ChickenFeederApp {
             this.updateManualPortionDisplay(this.getManualPortionUnits());
         }
 
+        if (this.elements.batchWindowInput && typeof this.config.batch_window_minutes === 'number') {
+            this.elements.batchWindowInput.value = this.config.batch_window_minutes;
+        }
+
+        if (this.elements.timezoneInput && this.config.timezone) {
+            this.elements.timezoneInput.value = this.config.timezone;
+        }
+
         if (this.elements.vibrationSettingsPanel) {
             const available = this.config.vibration_available !== false; // default to shown if API doesn't report it
             this.elements.vibrationSettingsPanel.style.display = available ? '' : 'none';
@@ -849,15 +896,30 @@ export class ChickenFeederApp {
         }
     }
 
+    updateBatchWindow() {
+        if (!this.config || !this.elements.batchWindowInput) return;
+
+        const minutes = Math.min(30, Math.max(0, parseInt(this.elements.batchWindowInput.value, 10) || 0));
+        this.config.batch_window_minutes = minutes;
+        this.elements.batchWindowInput.value = minutes;
+    }
+
     async saveScheduleOnly() {
         try {
             this.updatePortionUnit({ commit: true });
             this.updateVibrationSetting();
+            this.updateBatchWindow();
+
+            if (this.elements.timezoneInput) {
+                this.config.timezone = this.elements.timezoneInput.value.trim() || this.config.timezone;
+            }
 
             const scheduleConfig = {
                 schedules: this.config.schedules,
                 portion_unit_grams: this.getPortionUnitGrams(),
                 manual_portion_units: this.getManualPortionUnits(),
+                batch_window_minutes: this.config.batch_window_minutes || 0,
+                timezone: this.config.timezone,
                 vibration_enabled: this.config.vibration_enabled,
                 vibration_pulse_seconds: this.config.vibration_pulse_seconds
             };
@@ -865,7 +927,11 @@ export class ChickenFeederApp {
             const response = await this.saveConfig(scheduleConfig);
             
             if (response.success) {
-                this.showToast('Schedule saved!', 'success');
+                if (response.overlap_count) {
+                    this.showToast(`Schedule saved - ${response.overlap_count} overlapping time(s) merged into one feed`, 'info');
+                } else {
+                    this.showToast('Schedule saved!', 'success');
+                }
                 this.config = { ...this.config, ...scheduleConfig };
             } else {
                 this.showToast(response.error || 'Failed to save schedule', 'error');